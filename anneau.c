@@ -0,0 +1,247 @@
+/**
+ * @file    anneau.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de l'acces a io_uring \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "anneau.h"
+
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/**
+ * @brief Cree l'instance io_uring, avec les options reservees a un seul thread si possible
+ */
+static int creerAnneau(struct io_uring_params *parametres) {
+    int fd;
+
+    // Un seul thread soumet : le noyau peut alors differer le travail jusqu'a notre attente (6.1)
+    memset(parametres, 0, sizeof(*parametres));
+    parametres->flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+
+    if ((fd = (int) syscall(__NR_io_uring_setup, PROFONDEUR_ANNEAU, parametres)) >= 0) {
+        return fd;
+    }
+
+    // IORING_SETUP_SINGLE_ISSUER garantit au moins Linux 6.0, donc l'acceptation multishot
+    memset(parametres, 0, sizeof(*parametres));
+    parametres->flags = IORING_SETUP_SINGLE_ISSUER;
+
+    return (int) syscall(__NR_io_uring_setup, PROFONDEUR_ANNEAU, parametres);
+}
+
+/**
+ * @brief Cree la reserve de tampons fournis au noyau et les lui confie tous
+ */
+static int enregistrerTampons(Anneau *anneau) {
+    struct io_uring_buf_reg enregistrement;
+    unsigned i;
+
+    anneau->tampons = mmap(NULL, NOMBRE_TAMPONS_ANNEAU * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (anneau->tampons == MAP_FAILED) {
+        anneau->tampons = NULL;
+        perror("enregistrerTampons, erreur de mmap.");
+        return 0;
+    }
+
+    if ((anneau->zoneTampons = malloc((size_t) NOMBRE_TAMPONS_ANNEAU * TAILLE_TAMPON_ANNEAU)) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 0;
+    }
+
+    memset(&enregistrement, 0, sizeof(enregistrement));
+    enregistrement.ring_addr = (uint64_t) (uintptr_t) anneau->tampons;
+    enregistrement.ring_entries = NOMBRE_TAMPONS_ANNEAU;
+    enregistrement.bgid = GROUPE_TAMPONS_ANNEAU;
+
+    if (syscall(__NR_io_uring_register, anneau->fd, IORING_REGISTER_PBUF_RING, &enregistrement, 1) < 0) {
+        perror("enregistrerTampons, erreur de io_uring_register.");
+        return 0;
+    }
+
+    for (i = 0; i < NOMBRE_TAMPONS_ANNEAU; i++) {
+        rendreTampon(anneau, i);
+    }
+
+    return 1;
+}
+
+int initialiserAnneau(Anneau *anneau) {
+    struct io_uring_params parametres;
+    char *projection = NULL;
+    unsigned i;
+
+    memset(anneau, 0, sizeof(*anneau));
+
+    if ((anneau->fd = creerAnneau(&parametres)) < 0) {
+        perror("initialiserAnneau, erreur de io_uring_setup.");
+        return 0;
+    }
+
+    // Anneaux projetes ensemble, delai d'attente passe directement a io_uring_enter
+    if ((!(parametres.features & IORING_FEAT_SINGLE_MMAP)) || (!(parametres.features & IORING_FEAT_EXT_ARG))) {
+        fprintf(stderr, "initialiserAnneau, noyau trop ancien.\n");
+        close(anneau->fd);
+        return 0;
+    }
+
+    anneau->tailleAnneaux = parametres.sq_off.array + parametres.sq_entries * sizeof(unsigned);
+    if (parametres.cq_off.cqes + parametres.cq_entries * sizeof(struct io_uring_cqe) > anneau->tailleAnneaux) {
+        anneau->tailleAnneaux = parametres.cq_off.cqes + parametres.cq_entries * sizeof(struct io_uring_cqe);
+    }
+    anneau->tailleSqes = parametres.sq_entries * sizeof(struct io_uring_sqe);
+
+    anneau->projectionAnneaux = mmap(NULL, anneau->tailleAnneaux, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, anneau->fd, IORING_OFF_SQ_RING);
+    anneau->sqes = mmap(NULL, anneau->tailleSqes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, anneau->fd, IORING_OFF_SQES);
+
+    if ((anneau->projectionAnneaux == MAP_FAILED) || (anneau->sqes == MAP_FAILED)) {
+        perror("initialiserAnneau, erreur de mmap.");
+        if (anneau->projectionAnneaux != MAP_FAILED) {
+            munmap(anneau->projectionAnneaux, anneau->tailleAnneaux);
+        }
+        if (anneau->sqes != MAP_FAILED) {
+            munmap(anneau->sqes, anneau->tailleSqes);
+        }
+        close(anneau->fd);
+        return 0;
+    }
+
+    projection = anneau->projectionAnneaux;
+    anneau->sqTete = (unsigned *) (void *) (projection + parametres.sq_off.head);
+    anneau->sqQueue = (unsigned *) (void *) (projection + parametres.sq_off.tail);
+    anneau->sqMasque = *(unsigned *) (void *) (projection + parametres.sq_off.ring_mask);
+    anneau->sqTableau = (unsigned *) (void *) (projection + parametres.sq_off.array);
+    anneau->cqTete = (unsigned *) (void *) (projection + parametres.cq_off.head);
+    anneau->cqQueue = (unsigned *) (void *) (projection + parametres.cq_off.tail);
+    anneau->cqMasque = *(unsigned *) (void *) (projection + parametres.cq_off.ring_mask);
+    anneau->cqes = (struct io_uring_cqe *) (void *) (projection + parametres.cq_off.cqes);
+    anneau->sqQueueLocale = *anneau->sqQueue;
+
+    // Chaque case du tableau designe l'entree de meme rang, une fois pour toutes
+    for (i = 0; i <= anneau->sqMasque; i++) {
+        anneau->sqTableau[i] = i;
+    }
+
+    if (!(enregistrerTampons(anneau))) {
+        terminerAnneau(anneau);
+        return 0;
+    }
+
+    return 1;
+}
+
+void terminerAnneau(Anneau *anneau) {
+    if (anneau->tampons != NULL) {
+        munmap(anneau->tampons, NOMBRE_TAMPONS_ANNEAU * sizeof(struct io_uring_buf));
+    }
+    free(anneau->zoneTampons);
+    munmap(anneau->sqes, anneau->tailleSqes);
+    munmap(anneau->projectionAnneaux, anneau->tailleAnneaux);
+    close(anneau->fd);
+}
+
+/**
+ * @brief Publie les entrees preparees et les soumet au noyau, en attendant eventuellement
+ */
+static int entrerAnneau(Anneau *anneau, unsigned attendues, long delaiMs) {
+    struct io_uring_getevents_arg argument;
+    struct __kernel_timespec delai;
+    unsigned drapeaux = 0;
+    long retour;
+
+    // Le noyau ne voit les nouvelles entrees qu'une fois la queue publiee
+    __atomic_store_n(anneau->sqQueue, anneau->sqQueueLocale, __ATOMIC_RELEASE);
+
+    memset(&argument, 0, sizeof(argument));
+    if (attendues > 0) {
+        delai.tv_sec = delaiMs / 1000;
+        delai.tv_nsec = (delaiMs % 1000) * 1000000;
+        argument.ts = (uint64_t) (uintptr_t) &delai;
+        drapeaux = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    }
+
+    retour = syscall(__NR_io_uring_enter, anneau->fd, anneau->aSoumettre, attendues, drapeaux,
+                     (attendues > 0) ? &argument : NULL, (attendues > 0) ? sizeof(argument) : 0);
+
+    if (retour < 0) {
+        // Delai ecoule, signal ou anneau de completion a vider : rien d'anormal
+        if ((errno == ETIME) || (errno == EINTR) || (errno == EBUSY) || (errno == EAGAIN)) {
+            return 1;
+        }
+        perror("entrerAnneau, erreur de io_uring_enter.");
+        return 0;
+    }
+
+    anneau->aSoumettre -= (unsigned) retour;
+
+    return 1;
+}
+
+struct io_uring_sqe *prendreSoumission(Anneau *anneau) {
+    struct io_uring_sqe *soumission = NULL;
+
+    // Anneau plein : on soumet ce qui est pret pour liberer des entrees
+    while (anneau->sqQueueLocale - __atomic_load_n(anneau->sqTete, __ATOMIC_ACQUIRE) > anneau->sqMasque) {
+        if (!(entrerAnneau(anneau, 0, 0))) {
+            return NULL;
+        }
+    }
+
+    soumission = &anneau->sqes[anneau->sqQueueLocale & anneau->sqMasque];
+    memset(soumission, 0, sizeof(*soumission));
+    anneau->sqQueueLocale++;
+    anneau->aSoumettre++;
+
+    return soumission;
+}
+
+int soumettreEtAttendre(Anneau *anneau, long delaiMs) {
+    // Les completions deja presentes sont traitees sans attendre
+    if (prochaineCompletion(anneau) != NULL) {
+        return (anneau->aSoumettre > 0) ? entrerAnneau(anneau, 0, 0) : 1;
+    }
+
+    return entrerAnneau(anneau, 1, delaiMs);
+}
+
+struct io_uring_cqe *prochaineCompletion(Anneau *anneau) {
+    unsigned tete = *anneau->cqTete;
+
+    if (tete == __atomic_load_n(anneau->cqQueue, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    return &anneau->cqes[tete & anneau->cqMasque];
+}
+
+void consommerCompletion(Anneau *anneau) {
+    __atomic_store_n(anneau->cqTete, *anneau->cqTete + 1, __ATOMIC_RELEASE);
+}
+
+char *tamponFourni(Anneau *anneau, unsigned identifiant) {
+    return &anneau->zoneTampons[(size_t) identifiant * TAILLE_TAMPON_ANNEAU];
+}
+
+void rendreTampon(Anneau *anneau, unsigned identifiant) {
+    struct io_uring_buf *tampon = &anneau->tampons[anneau->queueTampons & (NOMBRE_TAMPONS_ANNEAU - 1)];
+
+    tampon->addr = (uint64_t) (uintptr_t) tamponFourni(anneau, identifiant);
+    tampon->len = TAILLE_TAMPON_ANNEAU;
+    tampon->bid = (unsigned short) identifiant;
+    anneau->queueTampons++;
+
+    // La queue de la reserve est superposee au champ resv du premier tampon
+    __atomic_store_n(&anneau->tampons[0].resv, anneau->queueTampons, __ATOMIC_RELEASE);
+}
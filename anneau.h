@@ -0,0 +1,125 @@
+/**
+ * @file    anneau.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de l'acces a io_uring \n
+ *          Enveloppe minimale des appels systeme io_uring (sans liburing) :
+ *          projection des anneaux de soumission et de completion, reserve
+ *          de tampons fournis au noyau pour les receptions, soumission
+ *          groupee et attente avec delai.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __ANNEAU_H__
+#define __ANNEAU_H__
+
+#include "serveur.h"
+
+#include <linux/io_uring.h>
+
+/* Nombre d'entrees de l'anneau de soumission (celui de completion est deux fois plus grand) */
+#define PROFONDEUR_ANNEAU 256
+/* Nombre et taille des tampons fournis au noyau pour les receptions */
+#define NOMBRE_TAMPONS_ANNEAU 256
+#define TAILLE_TAMPON_ANNEAU 4096
+/* Groupe des tampons fournis */
+#define GROUPE_TAMPONS_ANNEAU 0
+
+/**
+ * @brief Anneaux io_uring d'un travailleur, projetes en memoire
+ */
+typedef struct {
+    int fd;
+    /* anneau de soumission */
+    unsigned *sqTete;
+    unsigned *sqQueue;
+    unsigned sqMasque;
+    unsigned *sqTableau;
+    struct io_uring_sqe *sqes;
+    unsigned sqQueueLocale;         /* entrees preparees, pas encore publiees */
+    unsigned aSoumettre;            /* entrees publiees, pas encore soumises */
+    /* anneau de completion */
+    unsigned *cqTete;
+    unsigned *cqQueue;
+    unsigned cqMasque;
+    struct io_uring_cqe *cqes;
+    /* projections a liberer */
+    void *projectionAnneaux;
+    size_t tailleAnneaux;
+    size_t tailleSqes;
+    /* tampons fournis pour les receptions */
+    struct io_uring_buf *tampons;
+    char *zoneTampons;
+    unsigned short queueTampons;
+} Anneau;
+
+/**
+ * @brief   Cree les anneaux et la reserve de tampons fournis \n
+ *          Note : echoue si le noyau ne connait pas io_uring, ou pas les
+ *          fonctions utilisees (Linux 6.0 au minimum)
+ *
+ * @param anneau    Anneau a initialiser
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int initialiserAnneau(Anneau *anneau);
+
+/**
+ * @brief Libere les anneaux et la reserve de tampons
+ *
+ * @param anneau    Anneau initialise
+ */
+void terminerAnneau(Anneau *anneau);
+
+/**
+ * @brief   Prend une entree de soumission vide \n
+ *          Note : si l'anneau est plein, les entrees en attente sont soumises d'abord
+ *
+ * @param anneau    Anneau du travailleur
+ * @return          struct io_uring_sqe* -> Retourne l'entree a remplir, NULL en cas d'erreur
+ */
+struct io_uring_sqe *prendreSoumission(Anneau *anneau);
+
+/**
+ * @brief Soumet les entrees preparees et attend au moins une completion ou le delai
+ *
+ * @param anneau    Anneau du travailleur
+ * @param delaiMs   Attente maximale en millisecondes
+ * @return          int -> Retourne 1 si ca s'est bien passe (delai ecoule compris), 0 en cas d'erreur
+ */
+int soumettreEtAttendre(Anneau *anneau, long delaiMs);
+
+/**
+ * @brief Renvoie la completion suivante sans la retirer de l'anneau
+ *
+ * @param anneau    Anneau du travailleur
+ * @return          struct io_uring_cqe* -> Retourne la completion, NULL s'il n'y en a plus
+ */
+struct io_uring_cqe *prochaineCompletion(Anneau *anneau);
+
+/**
+ * @brief Retire de l'anneau la completion renvoyee par prochaineCompletion
+ *
+ * @param anneau    Anneau du travailleur
+ */
+void consommerCompletion(Anneau *anneau);
+
+/**
+ * @brief Adresse d'un tampon fourni designe par une completion de reception
+ *
+ * @param anneau        Anneau du travailleur
+ * @param identifiant   Identifiant du tampon (bits hauts des drapeaux de la completion)
+ * @return              char* -> Retourne le debut du tampon
+ */
+char *tamponFourni(Anneau *anneau, unsigned identifiant);
+
+/**
+ * @brief Rend au noyau un tampon fourni dont le contenu a ete recopie
+ *
+ * @param anneau        Anneau du travailleur
+ * @param identifiant   Identifiant du tampon
+ */
+void rendreTampon(Anneau *anneau, unsigned identifiant);
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file    benchRecherche.c
+ * @author  Coulais Alexandre
+ * @brief   Micro-benchmark de l'analyse d'une requete chargee d'entetes \n
+ *          Compare l'ancienne boucle de Reception (copie octet par octet
+ *          jusqu'a chaque '\\n') a analyserRequete avec chaque niveau de
+ *          recherche disponible (scalaire, SSE4.2, AVX2).
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "../recherche.h"
+#include "../requete.h"
+
+#include <time.h>
+
+#define ITERATIONS 200000
+
+/* Requete typique d'un navigateur, avec cookies et user-agent volumineux */
+static const char requeteNavigateur[] =
+    "GET /images/photo.jpg?v=1605271234 HTTP/1.1\r\n"
+    "Host: www.exemple.fr:13214\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:83.0) Gecko/20100101 Firefox/83.0\r\n"
+    "Accept: image/webp,image/avif,image/apng,image/svg+xml,image/*,*/*;q=0.8\r\n"
+    "Accept-Language: fr-FR,fr;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Referer: http://www.exemple.fr:13214/index.html\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: session=4f1c2e7a9b3d5f60718293a4b5c6d7e8f9a0b1c2d3e4f5a6b7c8d9e0f1a2b3c4; "
+    "preferences=theme%3Dsombre%26langue%3Dfr%26taille%3Dgrande; _suivi=GA1.2.1234567890.1605271234; "
+    "_suivi_id=GA1.2.9876543210.1605271234; panier=article1%2Carticle2%2Carticle3%2Carticle4\r\n"
+    "Sec-Fetch-Dest: image\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "If-None-Match: \"5fae3c1a-4b2e1\"\r\n"
+    "If-Modified-Since: Fri, 13 Nov 2020 12:34:56 GMT\r\n"
+    "\r\n";
+
+/* Empeche le compilateur d'eliminer les calculs mesures */
+static volatile size_t puits;
+
+/**
+ * @brief Temps monotone en nanosecondes
+ */
+static double maintenantNs(void) {
+    struct timespec instant;
+
+    clock_gettime(CLOCK_MONOTONIC, &instant);
+
+    return (double) instant.tv_sec * 1e9 + (double) instant.tv_nsec;
+}
+
+/**
+ * @brief Reproduction de l'ancienne boucle de Reception : chaque ligne est copiee
+ *        octet par octet dans un tableau local jusqu'au '\\n'
+ */
+static size_t lignesAncienneMethode(const char *tampon, size_t taille) {
+    char message[LONGUEUR_TAMPON];
+    size_t debut = 0, index, lignes = 0;
+
+    while (debut < taille) {
+        index = 0;
+        while ((debut < taille) && (tampon[debut] != '\n')) {
+            message[index++] = tampon[debut++];
+        }
+        message[index++] = '\n';
+        message[index] = '\0';
+        debut++;
+        lignes += (size_t) message[0];
+    }
+
+    return lignes;
+}
+
+/**
+ * @brief Mesure analyserRequete avec un niveau de recherche donne
+ */
+static void mesurerAnalyse(NiveauRecherche niveauMax, size_t taille) {
+    Requete requete;
+    NiveauRecherche niveau = initialiserRecherche(niveauMax);
+    double debut, duree;
+    size_t reprise;
+    int i;
+
+    // On n'affiche pas deux fois un niveau non supporte par le processeur
+    if (niveau != niveauMax) {
+        return;
+    }
+
+    debut = maintenantNs();
+    for (i = 0; i < ITERATIONS; i++) {
+        reprise = 0;
+        puits = (size_t) analyserRequete(requeteNavigateur, taille, &requete, &reprise);
+    }
+    duree = maintenantNs() - debut;
+
+    printf("methode=analyse_%s octets=%lu ns_par_requete=%.1f entetes=%lu\n", nomRecherche(niveau),
+           (unsigned long) taille, duree / ITERATIONS, (unsigned long) requete.nombreEntetes);
+}
+
+int main(void) {
+    size_t taille = sizeof(requeteNavigateur) - 1;
+    double debut, duree;
+    int i;
+
+    debut = maintenantNs();
+    for (i = 0; i < ITERATIONS; i++) {
+        puits = lignesAncienneMethode(requeteNavigateur, taille);
+    }
+    duree = maintenantNs() - debut;
+
+    printf("methode=ancienne_boucle octets=%lu ns_par_requete=%.1f\n", (unsigned long) taille, duree / ITERATIONS);
+
+    mesurerAnalyse(RECHERCHE_SCALAIRE, taille);
+    mesurerAnalyse(RECHERCHE_SSE42, taille);
+    mesurerAnalyse(RECHERCHE_AVX2, taille);
+
+    return 0;
+}
@@ -0,0 +1,322 @@
+/**
+ * @file    chargeur.c
+ * @author  Coulais Alexandre
+ * @brief   Generateur de charge HTTP pour mesurer le serveur \n
+ *          Chaque client est un thread qui enchaine les requetes GET sur
+ *          une cible pendant une duree fixee, en reutilisant sa connexion
+ *          (keep-alive) ou en en ouvrant une par requete. Le resultat est
+ *          une ligne de champs cle=valeur, facile a comparer d'une version
+ *          a l'autre.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "../serveur.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#define TAILLE_RECEPTION 65536
+
+/**
+ * @brief Parametres communs a tous les clients
+ */
+typedef struct {
+    struct addrinfo *adresse;
+    char requete[1024];
+    size_t longueurRequete;
+    bool persistant;
+    uint64_t fin;               /* instant d'arret en nanosecondes */
+} Parametres;
+
+/**
+ * @brief Mesures d'un client, fusionnees a la fin
+ */
+typedef struct {
+    const Parametres *parametres;
+    uint64_t *latences;         /* duree de chaque requete en nanosecondes */
+    size_t nombre;
+    size_t capacite;
+    uint64_t octets;
+    uint64_t erreurs;
+} Client;
+
+/**
+ * @brief Instant courant de l'horloge monotone en nanosecondes
+ */
+static uint64_t instantNs(void) {
+    struct timespec instant;
+
+    clock_gettime(CLOCK_MONOTONIC, &instant);
+
+    return (uint64_t) instant.tv_sec * 1000000000u + (uint64_t) instant.tv_nsec;
+}
+
+/**
+ * @brief Ouvre une connexion vers le serveur
+ */
+static int connecter(const Parametres *parametres) {
+    int fd, actif = 1;
+
+    if ((fd = socket(parametres->adresse->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+        return -1;
+    }
+
+    if (connect(fd, parametres->adresse->ai_addr, parametres->adresse->ai_addrlen) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &actif, sizeof(actif));
+
+    return fd;
+}
+
+/**
+ * @brief Envoie la requete puis lit une reponse complete (entete et corps)
+ *
+ * @return ssize_t -> Retourne le nombre d'octets de la reponse, -1 en cas d'erreur
+ */
+static ssize_t echanger(int fd, const Parametres *parametres, char *tampon) {
+    size_t recu = 0, finEntete = 0;
+    ssize_t lu;
+    uint64_t longueurCorps = 0, reste;
+    char *position = NULL;
+
+    if (send(fd, parametres->requete, parametres->longueurRequete, MSG_NOSIGNAL) != (ssize_t) parametres->longueurRequete) {
+        return -1;
+    }
+
+    // L'entete est lu jusqu'a la ligne vide
+    while ((position = memmem(tampon, recu, "\r\n\r\n", 4)) == NULL) {
+        if ((recu == TAILLE_RECEPTION) || ((lu = recv(fd, &tampon[recu], TAILLE_RECEPTION - recu, 0)) <= 0)) {
+            return -1;
+        }
+        recu += (size_t) lu;
+    }
+    finEntete = (size_t) (position - tampon) + 4;
+
+    if (strncmp(tampon, "HTTP/1.1 200", 12) != 0) {
+        return -1;
+    }
+
+    // Le nom de l'entete n'est pas sensible a la casse
+    *position = '\0';
+    if ((position = strcasestr(tampon, "\r\nContent-length:")) == NULL) {
+        return -1;
+    }
+    longueurCorps = strtoull(position + strlen("\r\nContent-length:"), NULL, 10);
+
+    // Le corps est lu sans etre conserve
+    reste = longueurCorps - (recu - finEntete);
+    while (reste > 0) {
+        if ((lu = recv(fd, tampon, (reste < TAILLE_RECEPTION) ? (size_t) reste : TAILLE_RECEPTION, 0)) <= 0) {
+            return -1;
+        }
+        reste -= (uint64_t) lu;
+    }
+
+    return (ssize_t) (finEntete + longueurCorps);
+}
+
+/**
+ * @brief Corps d'un client : requetes en boucle fermee jusqu'a l'instant d'arret
+ */
+static void *client(void *arg) {
+    Client *client = arg;
+    const Parametres *parametres = client->parametres;
+    char *tampon = NULL;
+    uint64_t debut;
+    ssize_t taille;
+    int fd = -1;
+
+    if ((tampon = malloc(TAILLE_RECEPTION)) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return NULL;
+    }
+
+    while ((debut = instantNs()) < parametres->fin) {
+        // La mesure d'une requete sans keep-alive comprend l'etablissement de la connexion
+        if ((fd < 0) && ((fd = connecter(parametres)) < 0)) {
+            client->erreurs++;
+            continue;
+        }
+
+        taille = echanger(fd, parametres, tampon);
+
+        if ((taille < 0) || (!(parametres->persistant))) {
+            close(fd);
+            fd = -1;
+        }
+
+        if (taille < 0) {
+            client->erreurs++;
+            continue;
+        }
+
+        if (client->nombre == client->capacite) {
+            client->capacite = (client->capacite > 0) ? client->capacite * 2 : 4096;
+            if ((client->latences = realloc(client->latences, client->capacite * sizeof(uint64_t))) == NULL) {
+                fprintf(stderr, "Erreur d'allocation memoire\n");
+                break;
+            }
+        }
+
+        client->latences[client->nombre++] = instantNs() - debut;
+        client->octets += (uint64_t) taille;
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(tampon);
+
+    return NULL;
+}
+
+/**
+ * @brief Comparaison de deux latences pour qsort
+ */
+static int comparerLatences(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Latence au centile demande (en millieme), en microsecondes
+ */
+static double centile(const uint64_t *latences, size_t nombre, size_t milliemes) {
+    if (nombre == 0) {
+        return 0.0;
+    }
+
+    return (double) latences[(nombre - 1) * milliemes / 1000] / 1000.0;
+}
+
+/**
+ * @brief Affiche la syntaxe de la ligne de commande
+ */
+static void usage(char *programme) {
+    fprintf(stderr, "Usage : %s [-a adresse] [-p port] [-c clients] [-d duree en s] [-f] chemin\n"
+                    "        -f : une connexion par requete (sans keep-alive)\n", programme);
+}
+
+int main(int argc, char *argv[]) {
+    Parametres parametres;
+    struct addrinfo indices;
+    char *adresse = "127.0.0.1", *service = "13214", *chemin = NULL;
+    long nombreClients = 4, duree = 5;
+    Client *clients = NULL;
+    pthread_t *threads = NULL;
+    uint64_t *latences = NULL, debut, octets = 0, erreurs = 0;
+    size_t total = 0;
+    double secondes;
+    int option, retour;
+    long i;
+
+    memset(&parametres, 0, sizeof(parametres));
+    parametres.persistant = TRUE;
+
+    while ((option = getopt(argc, argv, "a:p:c:d:f")) != -1) {
+        switch (option) {
+            case 'a':
+                adresse = optarg;
+                break;
+            case 'p':
+                service = optarg;
+                break;
+            case 'c':
+                nombreClients = strtol(optarg, NULL, 10);
+                break;
+            case 'd':
+                duree = strtol(optarg, NULL, 10);
+                break;
+            case 'f':
+                parametres.persistant = FALSE;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if ((optind != argc - 1) || (nombreClients < 1) || (nombreClients > 4096) || (duree < 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+    chemin = argv[optind];
+
+    memset(&indices, 0, sizeof(indices));
+    indices.ai_family = AF_UNSPEC;
+    indices.ai_socktype = SOCK_STREAM;
+
+    if ((retour = getaddrinfo(adresse, service, &indices, &parametres.adresse)) != 0) {
+        fprintf(stderr, "getaddrinfo : %s\n", gai_strerror(retour));
+        return 1;
+    }
+
+    retour = snprintf(parametres.requete, sizeof(parametres.requete),
+                      "GET %s HTTP/1.1\r\nHost: %s\r\n%s\r\n",
+                      chemin, adresse, parametres.persistant ? "" : "Connection: close\r\n");
+    if ((retour < 0) || ((size_t) retour >= sizeof(parametres.requete))) {
+        fprintf(stderr, "Chemin trop long\n");
+        return 1;
+    }
+    parametres.longueurRequete = (size_t) retour;
+
+    if (((clients = calloc((size_t) nombreClients, sizeof(Client))) == NULL) ||
+        ((threads = calloc((size_t) nombreClients, sizeof(pthread_t))) == NULL)) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 1;
+    }
+
+    debut = instantNs();
+    parametres.fin = debut + (uint64_t) duree * 1000000000u;
+
+    for (i = 0; i < nombreClients; i++) {
+        clients[i].parametres = &parametres;
+        if (pthread_create(&threads[i], NULL, client, &clients[i]) != 0) {
+            fprintf(stderr, "Impossible de creer le client %ld\n", i);
+            return 1;
+        }
+    }
+
+    // Les mesures de tous les clients sont rassemblees pour calculer les centiles
+    for (i = 0; i < nombreClients; i++) {
+        pthread_join(threads[i], NULL);
+        total += clients[i].nombre;
+    }
+    secondes = (double) (instantNs() - debut) / 1e9;
+
+    if ((latences = malloc((total + 1) * sizeof(uint64_t))) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 1;
+    }
+
+    total = 0;
+    for (i = 0; i < nombreClients; i++) {
+        memcpy(&latences[total], clients[i].latences, clients[i].nombre * sizeof(uint64_t));
+        total += clients[i].nombre;
+        octets += clients[i].octets;
+        erreurs += clients[i].erreurs;
+        free(clients[i].latences);
+    }
+    qsort(latences, total, sizeof(uint64_t), comparerLatences);
+
+    printf("chemin=%s mode=%s clients=%ld requetes=%lu erreurs=%lu requetes_par_s=%.0f "
+           "p50_us=%.1f p99_us=%.1f p999_us=%.1f octets_par_s=%.0f\n",
+           chemin, parametres.persistant ? "keepalive" : "fermeture", nombreClients,
+           (unsigned long) total, (unsigned long) erreurs, (double) total / secondes,
+           centile(latences, total, 500), centile(latences, total, 990), centile(latences, total, 999),
+           (double) octets / secondes);
+
+    free(latences);
+    free(clients);
+    free(threads);
+    freeaddrinfo(parametres.adresse);
+
+    return 0;
+}
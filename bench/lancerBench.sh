@@ -0,0 +1,29 @@
+#!/bin/sh
+# Mesure mainServer sur la boucle locale avec des fichiers generes :
+# une ligne cle=valeur par fichier et par mode (keep-alive ou une connexion par requete).
+# Variables : PORT, CLIENTS, DUREE (en s), TRAVAILLEURS.
+
+PORT=${PORT:-13280}
+CLIENTS=${CLIENTS:-8}
+DUREE=${DUREE:-5}
+TRAVAILLEURS=${TRAVAILLEURS:-2}
+
+RACINE=$(cd "$(dirname "$0")/.." && pwd)
+FIXTURES=$(mktemp -d)
+trap 'kill $SERVEUR 2>/dev/null; rm -rf "$FIXTURES"' EXIT INT TERM
+
+# Fichiers de 1 Kio, 100 Kio et 5 Mio
+head -c 1024 /dev/zero | tr '\0' 'a' > "$FIXTURES/page.html"
+head -c 102400 /dev/zero | tr '\0' 'b' > "$FIXTURES/style.css"
+head -c 5242880 /dev/urandom > "$FIXTURES/photo.jpg"
+cp "$RACINE/mime.types" "$FIXTURES/"
+
+cd "$FIXTURES" || exit 1
+"$RACINE/mainServer" -p "$PORT" -t "$TRAVAILLEURS" > serveur.log 2>&1 &
+SERVEUR=$!
+sleep 0.5
+
+for CHEMIN in /page.html /style.css /photo.jpg; do
+    "$RACINE/bench/chargeur" -p "$PORT" -c "$CLIENTS" -d "$DUREE" "$CHEMIN" || exit 1
+    "$RACINE/bench/chargeur" -p "$PORT" -c "$CLIENTS" -d "$DUREE" -f "$CHEMIN" || exit 1
+done
@@ -0,0 +1,327 @@
+/**
+ * @file    cache.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source du cache de reponses statiques \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "cache.h"
+#include "mesures.h"
+#include "racine.h"
+
+/* Budget commun a tous les travailleurs, fixe au demarrage */
+static size_t budgetCache = BUDGET_CACHE_DEFAUT;
+
+/* Variables cachees, propres a chaque travailleur : aucun verrou n'est necessaire */
+
+/* table de hachage des entrees par chemin */
+static _Thread_local EntreeCache *tableCache[TAILLE_TABLE_CACHE];
+/* liste des entrees de la plus recemment utilisee a la plus ancienne */
+static _Thread_local EntreeCache *teteLru;
+static _Thread_local EntreeCache *queueLru;
+/* nombre d'octets occupes par les entrees presentes */
+static _Thread_local size_t octetsCache;
+
+void configurerCache(size_t budgetOctets) {
+    budgetCache = budgetOctets;
+}
+
+/**
+ * @brief Hachage FNV-1a du chemin
+ */
+static size_t hacherChemin(const char *chemin) {
+    size_t hachage = 2166136261u;
+
+    while (*chemin != '\0') {
+        hachage ^= (unsigned char) *chemin++;
+        hachage *= 16777619u;
+    }
+
+    return hachage & (TAILLE_TABLE_CACHE - 1);
+}
+
+/**
+ * @brief Libere la memoire d'une entree
+ */
+static void libererEntree(EntreeCache *entree) {
+    free(entree->chemin);
+    free(entree->source);
+    free(entree->donnees);
+    free(entree);
+}
+
+/**
+ * @brief Detache une entree de la liste LRU
+ */
+static void detacherLru(EntreeCache *entree) {
+    if (entree->precedentLru != NULL) {
+        entree->precedentLru->suivantLru = entree->suivantLru;
+    } else {
+        teteLru = entree->suivantLru;
+    }
+
+    if (entree->suivantLru != NULL) {
+        entree->suivantLru->precedentLru = entree->precedentLru;
+    } else {
+        queueLru = entree->precedentLru;
+    }
+
+    entree->precedentLru = NULL;
+    entree->suivantLru = NULL;
+}
+
+/**
+ * @brief Place une entree en tete de la liste LRU
+ */
+static void placerEnTete(EntreeCache *entree) {
+    entree->suivantLru = teteLru;
+
+    if (teteLru != NULL) {
+        teteLru->precedentLru = entree;
+    }
+
+    teteLru = entree;
+
+    if (queueLru == NULL) {
+        queueLru = entree;
+    }
+}
+
+/**
+ * @brief Retire une entree du cache, elle n'est liberee qu'une fois plus aucune connexion ne l'emet
+ */
+static void retirerEntree(EntreeCache *entree) {
+    EntreeCache **courant = &tableCache[hacherChemin(entree->chemin)];
+
+    // On retire l'entree de son alveole
+    while (*courant != entree) {
+        courant = &(*courant)->suivantHachage;
+    }
+    *courant = entree->suivantHachage;
+
+    detacherLru(entree);
+    octetsCache -= entree->taille;
+    entree->retiree = TRUE;
+
+    if (entree->references == 0) {
+        libererEntree(entree);
+    }
+}
+
+/**
+ * @brief Indique si le fichier sur le disque est toujours celui mis en cache
+ */
+static bool estAJour(EntreeCache *entree, struct stat *infos) {
+    return (infos->st_dev == entree->peripherique) && (infos->st_ino == entree->inode) &&
+           (infos->st_size == entree->tailleFichier) &&
+           (infos->st_mtim.tv_sec == entree->modification.tv_sec) &&
+           (infos->st_mtim.tv_nsec == entree->modification.tv_nsec);
+}
+
+EntreeCache *chercherCache(char *chemin, Encodage encodage) {
+    EntreeCache *entree = tableCache[hacherChemin(chemin)];
+    struct stat infos;
+
+    // Une reponse non compressible convient a tous les encodages demandes
+    while ((entree != NULL) && ((strcmp(entree->chemin, chemin) != 0) ||
+                                ((entree->compressible) && (entree->encodage != encodage)))) {
+        entree = entree->suivantHachage;
+    }
+
+    if (entree == NULL) {
+        compterCache(FALSE);
+        return NULL;
+    }
+
+    // L'etat du fichier vient du cache de resolutions, tenu a jour par inotify : aucun appel systeme
+    if ((resoudreFichier(entree->source, &infos) < 0) || (!(estAJour(entree, &infos)))) {
+        retirerEntree(entree);
+        compterCache(FALSE);
+        return NULL;
+    }
+
+    detacherLru(entree);
+    placerEnTete(entree);
+    compterCache(TRUE);
+
+    return entree;
+}
+
+bool peutMettreEnCache(off_t taille) {
+    // Seuls les petits fichiers meritent une place en memoire
+    return (budgetCache > 0) && ((size_t) taille <= TAILLE_MAX_ENTREE_CACHE) && ((size_t) taille <= budgetCache / 4);
+}
+
+/**
+ * @brief Lit tout le contenu d'un fichier ouvert dans un tampon alloue
+ */
+static char *lireContenu(int fichier, size_t taille) {
+    char *contenu = NULL;
+
+    if ((contenu = malloc(taille + 1)) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return NULL;
+    }
+
+    if (pread(fichier, contenu, taille, 0) != (ssize_t) taille) {
+        free(contenu);
+        return NULL;
+    }
+
+    return contenu;
+}
+
+EntreeCache *mettreEnCache(char *chemin, char *typeContenu, Encodage encodage) {
+    EntreeCache *entree = NULL;
+    struct stat infos;
+    char entete[TAILLE_MAX_ENTETE], entetes[TAILLE_MAX_ENTETE], variante[PATH_MAX];
+    Validateurs validateurs;
+    char *source = chemin, *contenu = NULL, *compresse = NULL;
+    const char *corps = NULL;
+    Encodage encodageCorps = ENCODAGE_IDENTITE;
+    bool compressible = estCompressible(typeContenu);
+    int longueurEntete;
+    size_t taille, tailleCorps, alveole;
+    int fichier;
+
+    if (budgetCache == 0) {
+        return NULL;
+    }
+
+    // Un contenu non compressible n'a qu'une reponse, mise en cache sans encodage
+    if (!(compressible)) {
+        encodage = ENCODAGE_IDENTITE;
+    }
+
+    // La variante precompressee deposee a cote du fichier est servie telle quelle
+    if (chercherVariante(chemin, encodage, variante, sizeof(variante))) {
+        source = variante;
+        encodageCorps = encodage;
+    }
+
+    // Le descripteur appartient au cache de resolutions : il n'est pas ferme ici
+    if (((fichier = resoudreFichier(source, &infos)) < 0) || (!(peutMettreEnCache(infos.st_size)))) {
+        return NULL;
+    }
+
+    contenu = lireContenu(fichier, (size_t) infos.st_size);
+
+    if (contenu == NULL) {
+        fprintf(stderr, "Erreur a la lecture du fichier %s\n", source);
+        return NULL;
+    }
+
+    corps = contenu;
+    tailleCorps = (size_t) infos.st_size;
+
+    // Sinon on compresse ici, en ne gardant le resultat que s'il est plus petit
+    if ((encodage != encodageCorps) && (tailleCorps > 0) && ((compresse = malloc(tailleCorps)) != NULL)) {
+        if ((taille = compresser(encodage, contenu, tailleCorps, compresse, tailleCorps)) > 0) {
+            corps = compresse;
+            tailleCorps = taille;
+            encodageCorps = encodage;
+        }
+    }
+
+    // Les validateurs distinguent les representations par l'encodage demande, qui est la cle de l'entree
+    calculerValidateurs(&infos, encodage, &validateurs);
+
+    if ((formaterValidateurs(entetes, sizeof(entetes), &validateurs, entetesEncodage(encodageCorps, compressible)) < 0) ||
+        ((longueurEntete = formaterEntete(entete, sizeof(entete), "200 OK", typeContenu, (long long) tailleCorps,
+                                          entetes)) < 0)) {
+        free(contenu);
+        free(compresse);
+        return NULL;
+    }
+
+    taille = (size_t) longueurEntete + tailleCorps;
+
+    if (((entree = calloc(1, sizeof(EntreeCache))) == NULL) ||
+        ((entree->donnees = malloc(taille)) == NULL) ||
+        ((entree->chemin = strdup(chemin)) == NULL) ||
+        ((entree->source = strdup(source)) == NULL)) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        if (entree != NULL) {
+            libererEntree(entree);
+        }
+        free(contenu);
+        free(compresse);
+        return NULL;
+    }
+
+    // L'entete est serialise une fois pour toutes, suivi du contenu
+    memcpy(entree->donnees, entete, (size_t) longueurEntete);
+    memcpy(&entree->donnees[longueurEntete], corps, tailleCorps);
+    free(contenu);
+    free(compresse);
+
+    entree->encodage = encodage;
+    entree->compressible = compressible;
+    entree->encodageCorps = encodageCorps;
+    entree->typeContenu = typeContenu;
+    entree->validateurs = validateurs;
+    entree->taille = taille;
+    entree->tailleEntete = (size_t) longueurEntete;
+    entree->peripherique = infos.st_dev;
+    entree->inode = infos.st_ino;
+    entree->tailleFichier = infos.st_size;
+    entree->modification = infos.st_mtim;
+
+    // On evince les entrees les moins recemment utilisees jusqu'a faire de la place
+    while ((octetsCache + taille > budgetCache) && (queueLru != NULL)) {
+        retirerEntree(queueLru);
+    }
+
+    alveole = hacherChemin(chemin);
+    entree->suivantHachage = tableCache[alveole];
+    tableCache[alveole] = entree;
+    placerEnTete(entree);
+    octetsCache += taille;
+
+    return entree;
+}
+
+EntreeCache *creerEntreeHorsCache(char *donnees, size_t taille, size_t tailleEntete) {
+    EntreeCache *entree = NULL;
+
+    if ((entree = calloc(1, sizeof(EntreeCache))) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        free(donnees);
+        return NULL;
+    }
+
+    // Jamais dans la table ni la liste LRU : la derniere reference rendue la libere
+    entree->donnees = donnees;
+    entree->taille = taille;
+    entree->tailleEntete = tailleEntete;
+    entree->references = 1;
+    entree->retiree = TRUE;
+
+    return entree;
+}
+
+void prendreEntreeCache(EntreeCache *entree) {
+    entree->references++;
+}
+
+void relacherEntreeCache(EntreeCache *entree) {
+    entree->references--;
+
+    if ((entree->references == 0) && (entree->retiree)) {
+        libererEntree(entree);
+    }
+}
+
+int envoyerEntreeCache(Connexion *connexion, EntreeCache *entree) {
+    // La reponse est emise directement depuis le cache, a la suite des precedentes
+    connexion->statut = 200;
+    connexion->longueurCorps = (long long) (entree->taille - entree->tailleEntete);
+    return EmissionEntreeCache(connexion, entree);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file    cache.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration du cache de reponses statiques \n
+ *          Chaque travailleur garde en memoire les reponses completes
+ *          (entete et corps) des petits fichiers les plus demandes.
+ *          Le cache est borne en octets et evince les entrees les moins
+ *          recemment utilisees.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include "compression.h"
+#include "serveur.h"
+#include "validation.h"
+
+#include <time.h>
+
+/* Nombre d'alveoles de la table de hachage (puissance de 2) */
+#define TAILLE_TABLE_CACHE 1024
+/* Budget par defaut de chaque travailleur en octets */
+#define BUDGET_CACHE_DEFAUT (16 * 1024 * 1024)
+/* Taille maximale d'une reponse mise en cache, au-dela sendfile est plus interessant */
+#define TAILLE_MAX_ENTREE_CACHE (1024 * 1024)
+
+/**
+ * @brief Reponse complete d'un fichier conservee en memoire
+ */
+typedef struct EntreeCache {
+    char *chemin;
+    char *source;           /* fichier lu : le chemin lui-meme ou sa variante precompressee */
+    Encodage encodage;      /* encodage demande, qui distingue les variantes d'un meme chemin */
+    bool compressible;      /* FALSE si la reponse est la meme quel que soit l'encodage demande */
+    Encodage encodageCorps; /* encodage effectif du contenu, identite si la compression n'y gagnait rien */
+    char *typeContenu;      /* type MIME, pris dans la table chargee au demarrage */
+    Validateurs validateurs;
+    char *donnees;          /* entete HTTP suivi du contenu du fichier */
+    size_t taille;
+    size_t tailleEntete;    /* position du contenu dans les donnees */
+    dev_t peripherique;     /* identite du fichier lors de la mise en cache */
+    ino_t inode;
+    off_t tailleFichier;
+    struct timespec modification;
+    int references;         /* connexions en cours d'emission de cette entree */
+    bool retiree;           /* retiree du cache, liberee quand plus referencee */
+    struct EntreeCache *suivantHachage;
+    struct EntreeCache *precedentLru;
+    struct EntreeCache *suivantLru;
+} EntreeCache;
+
+/**
+ * @brief Fixe le budget memoire du cache de chaque travailleur
+ *
+ * @param budgetOctets  Nombre d'octets maximal occupe par les reponses en cache, 0 pour desactiver
+ */
+void configurerCache(size_t budgetOctets);
+
+/**
+ * @brief Indique si un fichier d'une taille donnee peut entrer dans le cache
+ *
+ * @param taille    Taille du fichier sur le disque
+ * @return          bool -> Retourne TRUE si mettreEnCache l'accepterait, FALSE sinon
+ */
+bool peutMettreEnCache(off_t taille);
+
+/**
+ * @brief   Recherche la reponse d'un fichier dans le cache du travailleur \n
+ *          Note : l'entree est revalidee (inode, taille, date) sur l'etat garde par
+ *          le cache de resolutions, tenu a jour par inotify
+ *
+ * @param chemin    Nom du fichier demande
+ * @param encodage  Encodage negocie avec le client
+ * @return          EntreeCache* -> Retourne l'entree a jour, NULL si absente ou perimee
+ */
+EntreeCache *chercherCache(char *chemin, Encodage encodage);
+
+/**
+ * @brief   Lit un fichier et met en cache sa reponse 200 complete dans l'encodage demande \n
+ *          Note : la variante precompressee du disque est preferee, sinon le contenu est
+ *          compresse ici ; s'il n'y gagne rien, il est garde tel quel
+ *
+ * @param chemin        Nom du fichier a mettre en cache
+ * @param typeContenu   Type MIME a annoncer dans l'entete
+ * @param encodage      Encodage negocie avec le client
+ * @return              EntreeCache* -> Retourne l'entree creee, NULL si le fichier ne peut
+ *                      ou ne doit pas etre mis en cache
+ */
+EntreeCache *mettreEnCache(char *chemin, char *typeContenu, Encodage encodage);
+
+/**
+ * @brief   Cree une entree hors du cache pour une reponse preparee d'avance, emise
+ *          sans copie comme les autres \n
+ *          Note : le createur en detient une reference ; l'entree est liberee quand
+ *          il l'a rendue et que plus aucune connexion ne l'emet
+ *
+ * @param donnees       Reponse complete allouee par malloc, prise en charge par l'entree
+ * @param taille        Taille de la reponse
+ * @param tailleEntete  Position du corps dans la reponse
+ * @return              EntreeCache* -> Retourne l'entree, NULL en cas d'erreur (donnees est alors liberee)
+ */
+EntreeCache *creerEntreeHorsCache(char *donnees, size_t taille, size_t tailleEntete);
+
+/**
+ * @brief Empeche la liberation d'une entree tant qu'une connexion l'emet
+ *
+ * @param entree    Entree a referencer
+ */
+void prendreEntreeCache(EntreeCache *entree);
+
+/**
+ * @brief Rend une entree prise par prendreEntreeCache, et la libere si elle a ete evincee
+ *
+ * @param entree    Entree a relacher
+ */
+void relacherEntreeCache(EntreeCache *entree);
+
+/**
+ * @brief   Programme l'envoi d'une reponse en cache apres les donnees deja en sortie \n
+ *          Note : la reponse est emise directement depuis le cache, sans copie
+ *
+ * @param connexion Connexion du client
+ * @param entree    Reponse a emettre
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerEntreeCache(Connexion *connexion, EntreeCache *entree);
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file    compression.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de la negociation et de la compression des contenus \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "compression.h"
+#include "racine.h"
+
+#include <brotli/encode.h>
+#include <zlib.h>
+
+/**
+ * @brief Lit la valeur q d'un element d'Accept-Encoding, en milliemes (1000 par defaut)
+ */
+static int lireQualite(const char *p, const char *fin) {
+    int qualite = 0, echelle = 100;
+
+    // Les parametres suivent le nom, separes par des points-virgules, jusqu'a la virgule suivante
+    while ((p < fin) && (*p != ';') && (*p != ',')) {
+        p++;
+    }
+
+    if ((p == fin) || (*p == ',')) {
+        return 1000;
+    }
+
+    while ((p < fin) && ((*p == ';') || (*p == ' ') || (*p == '\t'))) {
+        p++;
+    }
+
+    if ((fin - p < 2) || ((p[0] != 'q') && (p[0] != 'Q')) || (p[1] != '=')) {
+        return 1000;
+    }
+    p += 2;
+
+    // q vaut 0 ou 1, avec au plus trois decimales
+    if ((p < fin) && (*p == '1')) {
+        return 1000;
+    }
+
+    while ((p < fin) && ((*p == '0') || (*p == '.'))) {
+        p++;
+        if (p[-1] == '.') {
+            break;
+        }
+    }
+
+    while ((p < fin) && (isdigit((unsigned char) *p)) && (echelle > 0)) {
+        qualite += (*p++ - '0') * echelle;
+        echelle /= 10;
+    }
+
+    return qualite;
+}
+
+Encodage negocierEncodage(const Requete *requete) {
+    const Tranche *accepte = chercherEntete(requete, "Accept-Encoding");
+    int qualiteGzip = -1, qualiteBrotli = -1, qualiteAutres = -1, qualite;
+    const char *p = NULL, *fin = NULL;
+    Tranche nom;
+
+    if (accepte == NULL) {
+        return ENCODAGE_IDENTITE;
+    }
+
+    p = accepte->debut;
+    fin = accepte->debut + accepte->longueur;
+
+    while (p < fin) {
+        while ((p < fin) && ((*p == ' ') || (*p == '\t') || (*p == ','))) {
+            p++;
+        }
+
+        nom.debut = p;
+        while ((p < fin) && (*p != ',') && (*p != ';') && (*p != ' ') && (*p != '\t')) {
+            p++;
+        }
+        nom.longueur = (size_t) (p - nom.debut);
+
+        qualite = lireQualite(p, fin);
+
+        if (trancheEgaleCasse(&nom, "br")) {
+            qualiteBrotli = qualite;
+        } else if ((trancheEgaleCasse(&nom, "gzip")) || (trancheEgaleCasse(&nom, "x-gzip"))) {
+            qualiteGzip = qualite;
+        } else if (trancheEgale(&nom, "*")) {
+            qualiteAutres = qualite;
+        }
+
+        while ((p < fin) && (*p != ',')) {
+            p++;
+        }
+    }
+
+    // Un encodage non cite est couvert par *, s'il est present
+    if (qualiteBrotli < 0) {
+        qualiteBrotli = qualiteAutres;
+    }
+    if (qualiteGzip < 0) {
+        qualiteGzip = qualiteAutres;
+    }
+
+    // A qualite egale brotli l'emporte : il compresse mieux le texte
+    if ((qualiteBrotli > 0) && (qualiteBrotli >= qualiteGzip)) {
+        return ENCODAGE_BROTLI;
+    } else if (qualiteGzip > 0) {
+        return ENCODAGE_GZIP;
+    }
+
+    return ENCODAGE_IDENTITE;
+}
+
+bool estCompressible(const char *typeContenu) {
+    const char *sousType = NULL;
+
+    if (!(strncmp(typeContenu, "text/", 5))) {
+        return TRUE;
+    }
+
+    // Les formats structures en texte (json, xml, svg+xml, ...) se reconnaissent a leur sous-type
+    if ((sousType = strchr(typeContenu, '/')) == NULL) {
+        return FALSE;
+    }
+    sousType++;
+
+    return (strstr(sousType, "json") != NULL) || (strstr(sousType, "xml") != NULL) ||
+           (strstr(sousType, "javascript") != NULL) || (!(strcmp(sousType, "wasm")));
+}
+
+const char *entetesEncodage(Encodage encodage, bool compressible) {
+    if (!(compressible)) {
+        return "";
+    }
+
+    switch (encodage) {
+        case ENCODAGE_BROTLI:
+            return "Content-Encoding: br\r\nVary: Accept-Encoding\r\n";
+        case ENCODAGE_GZIP:
+            return "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+        default:
+            return "Vary: Accept-Encoding\r\n";
+    }
+}
+
+int chercherVariante(const char *chemin, Encodage encodage, char *variante, size_t maxVariante) {
+    struct stat infos;
+    int longueur;
+
+    if (encodage == ENCODAGE_IDENTITE) {
+        return 0;
+    }
+
+    longueur = snprintf(variante, maxVariante, "%s%s", chemin, (encodage == ENCODAGE_BROTLI) ? ".br" : ".gz");
+
+    if ((longueur < 0) || ((size_t) longueur >= maxVariante)) {
+        return 0;
+    }
+
+    // Une variante absente est gardee en cache comme un fichier present : pas d'appel systeme
+    return resoudreFichier(variante, &infos) >= 0;
+}
+
+/**
+ * @brief Compression gzip d'un contenu en une seule passe
+ */
+static size_t compresserGzip(const char *source, size_t tailleSource, char *destination, size_t maxDestination) {
+    z_stream flux;
+    size_t taille = 0;
+
+    memset(&flux, 0, sizeof(flux));
+
+    // 15 + 16 : fenetre maximale et enveloppe gzip plutot que zlib
+    if (deflateInit2(&flux, NIVEAU_GZIP, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "compresserGzip, erreur de deflateInit2\n");
+        return 0;
+    }
+
+    flux.next_in = (Bytef *) (uintptr_t) source;
+    flux.avail_in = (uInt) tailleSource;
+    flux.next_out = (Bytef *) destination;
+    flux.avail_out = (uInt) maxDestination;
+
+    // Si la sortie est trop petite, la compression ne fait rien gagner
+    if (deflate(&flux, Z_FINISH) == Z_STREAM_END) {
+        taille = flux.total_out;
+    }
+
+    deflateEnd(&flux);
+
+    return taille;
+}
+
+size_t compresser(Encodage encodage, const char *source, size_t tailleSource, char *destination, size_t maxDestination) {
+    size_t taille = maxDestination;
+
+    switch (encodage) {
+        case ENCODAGE_GZIP:
+            return compresserGzip(source, tailleSource, destination, maxDestination);
+        case ENCODAGE_BROTLI:
+            if (!(BrotliEncoderCompress(QUALITE_BROTLI, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                        tailleSource, (const uint8_t *) source, &taille, (uint8_t *) destination))) {
+                return 0;
+            }
+            return taille;
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * @file    compression.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de la negociation et de la compression
+ *          des contenus \n
+ *          L'encodage est choisi d'apres l'entete Accept-Encoding (brotli
+ *          prefere a gzip). Les variantes .br et .gz posees a cote des
+ *          fichiers sont servies telles quelles, sinon le contenu est
+ *          compresse une fois puis conserve par le cache.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __COMPRESSION_H__
+#define __COMPRESSION_H__
+
+#include "serveur.h"
+#include "requete.h"
+
+/* Niveaux de compression a la volee : le resultat est garde en cache, la lenteur ne se paie qu'une fois */
+#define NIVEAU_GZIP 6
+#define QUALITE_BROTLI 5
+
+/**
+ * @brief Encodages de contenu connus du serveur
+ */
+typedef enum {
+    ENCODAGE_IDENTITE,
+    ENCODAGE_GZIP,
+    ENCODAGE_BROTLI
+} Encodage;
+
+/**
+ * @brief   Choisit l'encodage de la reponse d'apres l'entete Accept-Encoding \n
+ *          Note : les valeurs q sont respectees, q=0 exclut un encodage
+ *
+ * @param requete   Requete analysee
+ * @return          Encodage -> Retourne l'encodage prefere accepte par le client
+ */
+Encodage negocierEncodage(const Requete *requete);
+
+/**
+ * @brief Indique si un type de contenu gagne a etre compresse (texte, scripts, JSON, XML, SVG)
+ *
+ * @param typeContenu   Type MIME du fichier
+ * @return              bool -> Retourne TRUE si le type est compressible, FALSE sinon
+ */
+bool estCompressible(const char *typeContenu);
+
+/**
+ * @brief   Lignes d'entete decrivant l'encodage d'une reponse \n
+ *          Note : une reponse d'un type compressible porte toujours
+ *          Vary: Accept-Encoding, meme non compressee
+ *
+ * @param encodage      Encodage effectif du corps
+ * @param compressible  TRUE si le type de contenu est compressible
+ * @return              const char* -> Retourne les lignes, terminees par \\r\\n, ou une chaine vide
+ */
+const char *entetesEncodage(Encodage encodage, bool compressible);
+
+/**
+ * @brief Recherche sur le disque la variante precompressee d'un fichier (fichier.gz, fichier.br)
+ *
+ * @param chemin        Nom du fichier demande
+ * @param encodage      Encodage souhaite
+ * @param variante      Destination du nom de la variante
+ * @param maxVariante   Taille de la destination
+ * @return              int -> Retourne 1 si une variante lisible existe, 0 sinon
+ */
+int chercherVariante(const char *chemin, Encodage encodage, char *variante, size_t maxVariante);
+
+/**
+ * @brief Compresse un contenu en memoire
+ *
+ * @param encodage      ENCODAGE_GZIP ou ENCODAGE_BROTLI
+ * @param source        Contenu a compresser
+ * @param tailleSource  Taille du contenu
+ * @param destination   Tampon recevant le contenu compresse
+ * @param maxDestination Taille du tampon
+ * @return              size_t -> Retourne la taille compressee, 0 si le resultat ne tient pas
+ *                      dans la destination ou en cas d'erreur
+ */
+size_t compresser(Encodage encodage, const char *source, size_t tailleSource, char *destination, size_t maxDestination);
+
+#endif
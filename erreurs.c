@@ -0,0 +1,187 @@
+/**
+ * @file    erreurs.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source des reponses d'erreur preparees \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "erreurs.h"
+#include "racine.h"
+
+/**
+ * @brief Description d'une reponse d'erreur
+ */
+typedef struct {
+    int code;
+    const char *raison;
+    const char *entetes;    /* lignes d'entete propres a l'erreur terminees par \r\n */
+    bool fermeture;         /* la requete suivante ne peut pas etre lue : la connexion est fermee */
+} DescriptionErreur;
+
+/* Reponses preparees, dans l'ordre de Erreur */
+static const DescriptionErreur descriptionsErreurs[NOMBRE_ERREURS] = {
+    [ERREUR_400] = { 400, "Bad Request", "", TRUE },
+    [ERREUR_404] = { 404, "Not Found", "", FALSE },
+    [ERREUR_405] = { 405, "Method Not Allowed", "Allow: GET\r\n", FALSE },
+    [ERREUR_408] = { 408, "Request Timeout", "", TRUE },
+    [ERREUR_413] = { 413, "Content Too Large", "", TRUE },
+    [ERREUR_414] = { 414, "URI Too Long", "", TRUE },
+    [ERREUR_431] = { 431, "Request Header Fields Too Large", "", TRUE },
+    [ERREUR_500] = { 500, "Internal Server Error", "", FALSE },
+    [ERREUR_503] = { 503, "Service Unavailable", "", TRUE }
+};
+
+/* Generation des pages d'erreur, augmentee a chaque demande de rechargement */
+static unsigned generationErreurs;
+
+/* Reponses preparees du travailleur et generation des pages lues */
+static _Thread_local EntreeCache *reponsesErreur[NOMBRE_ERREURS];
+static _Thread_local unsigned generationChargee;
+
+/**
+ * @brief   Lit le corps d'une page d'erreur sous la racine \n
+ *          Note : une page absente, vide ou trop grande est remplacee par la page minimale
+ *
+ * @return  char* -> Retourne le corps alloue par malloc, NULL s'il n'y a pas de page a lire
+ */
+static char *lirePageErreur(int code, size_t *taille) {
+    char nomPage[LONGUEUR_NOM_PAGE_ERREUR];
+    struct stat infos;
+    char *corps = NULL;
+    size_t lu = 0;
+    ssize_t retour;
+    int fichier;
+
+    snprintf(nomPage, sizeof(nomPage), "page%d.html", code);
+
+    // Le descripteur appartient au cache de resolutions : il n'est pas ferme ici
+    if (((fichier = resoudreFichier(nomPage, &infos)) < 0) || (infos.st_size == 0) ||
+        (infos.st_size > TAILLE_MAX_PAGE_ERREUR)) {
+        return NULL;
+    }
+
+    if ((corps = malloc((size_t) infos.st_size)) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return NULL;
+    }
+
+    while (lu < (size_t) infos.st_size) {
+        if ((retour = pread(fichier, &corps[lu], (size_t) infos.st_size - lu, (off_t) lu)) <= 0) {
+            fprintf(stderr, "Erreur a la lecture de la page d'erreur %s\n", nomPage);
+            free(corps);
+            return NULL;
+        }
+        lu += (size_t) retour;
+    }
+
+    *taille = lu;
+
+    return corps;
+}
+
+/**
+ * @brief Serialise une reponse d'erreur complete, entete et corps, dans une entree hors cache
+ */
+static EntreeCache *preparerErreur(Erreur erreur) {
+    const DescriptionErreur *description = &descriptionsErreurs[erreur];
+    char statut[64], entetes[TAILLE_MAX_ENTETE], pageMinimale[256];
+    char *corps = NULL, *donnees = NULL;
+    size_t tailleCorps = 0;
+    int longueurEntete;
+
+    snprintf(statut, sizeof(statut), "%d %s", description->code, description->raison);
+
+    // Un client refuse en surcharge sait quand revenir ; apres une requete illisible, on ferme
+    if (erreur == ERREUR_503) {
+        snprintf(entetes, sizeof(entetes), "%sRetry-After: %d\r\n", description->entetes, DELAI_REESSAI_SURCHARGE);
+    } else {
+        snprintf(entetes, sizeof(entetes), "%s", description->entetes);
+    }
+    if (description->fermeture) {
+        strncat(entetes, "Connection: close\r\n", sizeof(entetes) - strlen(entetes) - 1);
+    }
+
+    if ((corps = lirePageErreur(description->code, &tailleCorps)) == NULL) {
+        tailleCorps = (size_t) snprintf(pageMinimale, sizeof(pageMinimale),
+                                        "<!DOCTYPE html>\n<html><head><title>%s</title></head>"
+                                        "<body><h1>%s</h1></body></html>\n", statut, statut);
+    }
+
+    if ((donnees = malloc(TAILLE_MAX_ENTETE + tailleCorps)) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        free(corps);
+        return NULL;
+    }
+
+    if ((longueurEntete = formaterEntete(donnees, TAILLE_MAX_ENTETE, statut, "text/html", (long long) tailleCorps,
+                                         entetes)) < 0) {
+        free(corps);
+        free(donnees);
+        return NULL;
+    }
+
+    memcpy(&donnees[longueurEntete], (corps != NULL) ? corps : pageMinimale, tailleCorps);
+    free(corps);
+
+    return creerEntreeHorsCache(donnees, (size_t) longueurEntete + tailleCorps, (size_t) longueurEntete);
+}
+
+int chargerErreurs(void) {
+    EntreeCache *reponse = NULL;
+    // La generation est lue avant les pages : une demande arrivee pendant la lecture sera servie
+    unsigned generation = __atomic_load_n(&generationErreurs, __ATOMIC_ACQUIRE);
+    size_t i;
+    int retour = 1;
+
+    for (i = 0; i < NOMBRE_ERREURS; i++) {
+        // En cas d'echec, la reponse precedente reste en place
+        if ((reponse = preparerErreur((Erreur) i)) == NULL) {
+            retour = (reponsesErreur[i] != NULL);
+            continue;
+        }
+
+        // Les connexions qui emettent encore l'ancienne reponse la gardent jusqu'a son emission
+        if (reponsesErreur[i] != NULL) {
+            relacherEntreeCache(reponsesErreur[i]);
+        }
+        reponsesErreur[i] = reponse;
+    }
+
+    generationChargee = generation;
+
+    return retour;
+}
+
+void rechargerErreurs(void) {
+    __atomic_fetch_add(&generationErreurs, 1, __ATOMIC_RELEASE);
+}
+
+void actualiserErreurs(void) {
+    if (__atomic_load_n(&generationErreurs, __ATOMIC_RELAXED) != generationChargee) {
+        chargerErreurs();
+    }
+}
+
+const EntreeCache *reponseErreur(Erreur erreur) {
+    return reponsesErreur[erreur];
+}
+
+int envoyerErreur(Connexion *connexion, Erreur erreur) {
+    EntreeCache *reponse = reponsesErreur[erreur];
+
+    if (descriptionsErreurs[erreur].fermeture) {
+        connexion->etat = ETAT_FERMETURE;
+    }
+
+    connexion->statut = descriptionsErreurs[erreur].code;
+    connexion->longueurCorps = (long long) (reponse->taille - reponse->tailleEntete);
+
+    return EmissionEntreeCache(connexion, reponse);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file    erreurs.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration des reponses d'erreur preparees \n
+ *          Chaque travailleur serialise une fois toutes ses reponses d'erreur,
+ *          entete et corps, dans des entrees hors cache : une erreur ne coute
+ *          qu'un segment de sortie, emis sans copie ni acces au disque. Le corps
+ *          est lu dans pageNNN.html sous la racine s'il existe, sinon une page
+ *          minimale le remplace. rechargerErreurs (SIGHUP) fait relire les pages
+ *          a chaque travailleur au tour suivant de son reacteur, hors des requetes.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __ERREURS_H__
+#define __ERREURS_H__
+
+#include "cache.h"
+#include "serveur.h"
+
+/* Taille maximale d'une page d'erreur lue sous la racine */
+#define TAILLE_MAX_PAGE_ERREUR (64 * 1024)
+/* Longueur du nom des pages d'erreur, pageNNN.html, zero final compris */
+#define LONGUEUR_NOM_PAGE_ERREUR 16
+
+/**
+ * @brief Reponses d'erreur preparees
+ */
+typedef enum {
+    ERREUR_400,             /* requete mal formee */
+    ERREUR_404,             /* fichier absent */
+    ERREUR_405,             /* methode autre que GET */
+    ERREUR_408,             /* requete commencee mais pas terminee dans le delai */
+    ERREUR_413,             /* requete avec un corps, que le serveur ne lit pas */
+    ERREUR_414,             /* ligne de requete plus longue que le tampon de reception */
+    ERREUR_431,             /* entetes plus longs que le tampon de reception */
+    ERREUR_500,             /* erreur interne */
+    ERREUR_503,             /* client refuse en surcharge */
+    NOMBRE_ERREURS
+} Erreur;
+
+/**
+ * @brief   Prepare les reponses d'erreur du travailleur courant \n
+ *          Note : a appeler au demarrage de chaque travailleur, apres initialiserDescripteurs
+ *
+ * @return  int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int chargerErreurs(void);
+
+/**
+ * @brief   Demande a tous les travailleurs de relire leurs pages d'erreur \n
+ *          Note : peut etre appelee depuis n'importe quel thread ; chaque travailleur
+ *          recharge ses reponses au tour suivant de son reacteur (actualiserErreurs)
+ */
+void rechargerErreurs(void);
+
+/**
+ * @brief   Recharge les reponses du travailleur courant si un rechargement a ete demande \n
+ *          Note : appelee par le reacteur entre deux lots d'evenements, jamais en repondant
+ *          a une requete : une erreur ne touche pas au systeme de fichiers
+ */
+void actualiserErreurs(void);
+
+/**
+ * @brief Reponse d'erreur preparee du travailleur courant, pour l'emettre hors d'une connexion
+ *
+ * @param erreur    Reponse voulue
+ * @return          EntreeCache* -> Retourne la reponse complete, entete et corps
+ */
+const EntreeCache *reponseErreur(Erreur erreur);
+
+/**
+ * @brief   Ajoute une reponse d'erreur preparee a la sortie du client, sans copie \n
+ *          Note : apres les erreurs qui empechent de lire la requete suivante (400,
+ *          408, 413, 414, 431, 503), la connexion est fermee une fois la sortie videe
+ *
+ * @param connexion Connexion du client
+ * @param erreur    Reponse a emettre
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerErreur(Connexion *connexion, Erreur erreur);
+
+#endif
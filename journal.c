@@ -0,0 +1,403 @@
+/**
+ * @file    journal.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source du journal des acces \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "journal.h"
+#include "mesures.h"
+
+#include <pthread.h>
+
+/* Place reservee dans le tampon d'ecriture pour une ligne, champs entierement echappes compris */
+#define TAILLE_MAX_LIGNE_JOURNAL 8192
+
+/**
+ * @brief   Anneau des enregistrements d'un travailleur \n
+ *          Note : les deux positions ne font que croitre ; chacune est ecrite par
+ *          un seul thread et occupe sa propre ligne de cache
+ */
+typedef struct {
+    _Alignas(TAILLE_LIGNE_CACHE) uint64_t tete;     /* prochain enregistrement lu par l'ecrivain */
+    _Alignas(TAILLE_LIGNE_CACHE) uint64_t queue;    /* prochain emplacement rempli par le travailleur */
+    _Alignas(TAILLE_LIGNE_CACHE) EnregistrementJournal enregistrements[CAPACITE_JOURNAL];
+} FileJournal;
+
+/* Configuration fixee au demarrage, puis en lecture seule */
+static bool journalActif;
+static FormatJournal formatJournal;
+static bool journalBloquant;
+static const char *cheminJournal;
+
+/* Rotation demandee (SIGHUP), consommee par l'ecrivain */
+static int reouvertureDemandee;
+
+/* Anneaux de tous les travailleurs inscrits, lus par l'ecrivain */
+static FileJournal *filesJournal[MAX_TRAVAILLEURS_JOURNAL];
+static int nombreFiles;
+
+/* Etat du thread ecrivain, qui est seul a y toucher */
+static int fichierJournal = -1;
+static char *tamponJournal;
+static size_t longueurTampon;
+
+/* Anneau du travailleur courant, NULL si le journal est inactif */
+static _Thread_local FileJournal *fileLocale;
+/* Derniere tete lue par le travailleur : il ne relit celle de l'ecrivain que si l'anneau semble plein */
+static _Thread_local uint64_t teteConnue;
+
+/**
+ * @brief Ecrit tout le tampon dans le fichier du journal
+ */
+static void ecrireTampon(void) {
+    size_t ecrit = 0;
+    ssize_t retour;
+
+    while (ecrit < longueurTampon) {
+        if ((retour = write(fichierJournal, &tamponJournal[ecrit], longueurTampon - ecrit)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Le disque refuse les lignes : on les perd plutot que de bloquer les anneaux
+            perror("ecrireTampon, erreur de write.");
+            break;
+        }
+        ecrit += (size_t) retour;
+    }
+
+    longueurTampon = 0;
+}
+
+/**
+ * @brief Ouvre le fichier du journal en ajout
+ *
+ * @return int -> Retourne le descripteur, -1 en cas d'erreur
+ */
+static int ouvrirJournal(void) {
+    int fichier;
+
+    if ((fichier = open(cheminJournal, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644)) < 0) {
+        fprintf(stderr, "Impossible d'ouvrir le journal %s : %s\n", cheminJournal, strerror(errno));
+    }
+
+    return fichier;
+}
+
+/**
+ * @brief Rouvre le fichier du journal apres sa rotation, l'ancien est garde en cas d'echec
+ */
+static void rouvrirJournal(void) {
+    int fichier;
+
+    if ((fichier = ouvrirJournal()) < 0) {
+        return;
+    }
+
+    close(fichierJournal);
+    fichierJournal = fichier;
+}
+
+/**
+ * @brief Recopie une chaine echappee : guillemets, barre oblique inverse et octets de controle
+ *
+ * @return char* -> Retourne la position qui suit la copie
+ */
+static char *ajouterEchappe(char *destination, const char *source) {
+    unsigned char octet;
+
+    for (; *source != '\0'; source++) {
+        octet = (unsigned char) *source;
+
+        if ((octet == '"') || (octet == '\\')) {
+            *destination++ = '\\';
+            *destination++ = (char) octet;
+        } else if ((octet < 0x20) || (octet == 0x7f) || ((octet >= 0x80) && (formatJournal != FORMAT_JSON))) {
+            // Un client ne doit pas pouvoir forger une fausse ligne du journal
+            destination += sprintf(destination, (formatJournal == FORMAT_JSON) ? "\\u%04x" : "\\x%02x", octet);
+        } else {
+            *destination++ = (char) octet;
+        }
+    }
+
+    return destination;
+}
+
+/**
+ * @brief Recopie une chaine echappee, ou - si elle est vide
+ */
+static char *ajouterChamp(char *destination, const char *source) {
+    if (*source == '\0') {
+        *destination++ = '-';
+        return destination;
+    }
+
+    return ajouterEchappe(destination, source);
+}
+
+/**
+ * @brief   Formate l'instant d'un enregistrement \n
+ *          Note : la date n'est recalculee qu'une fois par seconde
+ *
+ * @return  char* -> Retourne la position qui suit la date
+ */
+static char *ajouterDate(char *destination, const struct timespec *horodatage) {
+    static time_t secondeFormatee = -1;
+    static char date[32], zone[8];
+    struct tm decomposee;
+
+    if (horodatage->tv_sec != secondeFormatee) {
+        localtime_r(&horodatage->tv_sec, &decomposee);
+        strftime(date, sizeof(date), (formatJournal == FORMAT_JSON) ? "%Y-%m-%dT%H:%M:%S" : "%d/%b/%Y:%H:%M:%S",
+                 &decomposee);
+        strftime(zone, sizeof(zone), "%z", &decomposee);
+        secondeFormatee = horodatage->tv_sec;
+    }
+
+    if (formatJournal == FORMAT_JSON) {
+        return destination + sprintf(destination, "%s.%03ld%s", date, horodatage->tv_nsec / 1000000, zone);
+    }
+
+    return destination + sprintf(destination, "%s %s", date, zone);
+}
+
+/**
+ * @brief Formate un enregistrement en une ligne du journal
+ *
+ * @return size_t -> Retourne la longueur de la ligne
+ */
+static size_t formaterEnregistrement(char *destination, const EnregistrementJournal *enregistrement) {
+    char *p = destination;
+
+    if (formatJournal == FORMAT_JSON) {
+        p += sprintf(p, "{\"time\":\"");
+        p = ajouterDate(p, &enregistrement->horodatage);
+        p += sprintf(p, "\",\"client\":\"");
+        p = ajouterEchappe(p, enregistrement->client);
+        p += sprintf(p, "\",\"method\":\"");
+        p = ajouterEchappe(p, enregistrement->methode);
+        p += sprintf(p, "\",\"target\":\"");
+        p = ajouterEchappe(p, enregistrement->cible);
+        p += sprintf(p, "\",\"protocol\":\"");
+        p = ajouterEchappe(p, enregistrement->version);
+        p += sprintf(p, "\",\"status\":%d,\"bytes\":", enregistrement->statut);
+        // La longueur d'un corps en flux n'est pas connue quand la requete est journalisee
+        p += (enregistrement->octets >= 0) ? sprintf(p, "%lld", enregistrement->octets) : sprintf(p, "null");
+        p += sprintf(p, ",\"duration_us\":%llu,\"referer\":\"", (unsigned long long) enregistrement->duree);
+        p = ajouterEchappe(p, enregistrement->referent);
+        p += sprintf(p, "\",\"user_agent\":\"");
+        p = ajouterEchappe(p, enregistrement->agent);
+        p += sprintf(p, "\"}\n");
+
+        return (size_t) (p - destination);
+    }
+
+    // hote - - [date] "requete" statut octets, comme Apache
+    p = ajouterChamp(p, enregistrement->client);
+    p += sprintf(p, " - - [");
+    p = ajouterDate(p, &enregistrement->horodatage);
+    p += sprintf(p, "] \"");
+    p = ajouterEchappe(p, enregistrement->methode);
+    *p++ = ' ';
+    p = ajouterEchappe(p, enregistrement->cible);
+    *p++ = ' ';
+    p = ajouterEchappe(p, enregistrement->version);
+    p += sprintf(p, "\" %d ", enregistrement->statut);
+    p += (enregistrement->octets > 0) ? sprintf(p, "%lld", enregistrement->octets) : sprintf(p, "-");
+
+    if (formatJournal == FORMAT_COMBINE) {
+        p += sprintf(p, " \"");
+        p = ajouterChamp(p, enregistrement->referent);
+        p += sprintf(p, "\" \"");
+        p = ajouterChamp(p, enregistrement->agent);
+        *p++ = '"';
+    }
+
+    *p++ = '\n';
+
+    return (size_t) (p - destination);
+}
+
+/**
+ * @brief Formate tous les enregistrements en attente dans les anneaux et les ecrit
+ *
+ * @return size_t -> Retourne le nombre d'enregistrements traites
+ */
+static size_t viderFiles(void) {
+    int nombre = __atomic_load_n(&nombreFiles, __ATOMIC_ACQUIRE);
+    FileJournal *file = NULL;
+    uint64_t tete, queue;
+    size_t traites = 0;
+    int i;
+
+    if (nombre > MAX_TRAVAILLEURS_JOURNAL) {
+        nombre = MAX_TRAVAILLEURS_JOURNAL;
+    }
+
+    for (i = 0; i < nombre; i++) {
+        if ((file = __atomic_load_n(&filesJournal[i], __ATOMIC_ACQUIRE)) == NULL) {
+            continue;
+        }
+
+        tete = file->tete;
+        queue = __atomic_load_n(&file->queue, __ATOMIC_ACQUIRE);
+
+        for (; tete != queue; tete++) {
+            if (longueurTampon + TAILLE_MAX_LIGNE_JOURNAL > TAILLE_TAMPON_JOURNAL) {
+                ecrireTampon();
+            }
+            longueurTampon += formaterEnregistrement(&tamponJournal[longueurTampon],
+                                                     &file->enregistrements[tete & (CAPACITE_JOURNAL - 1)]);
+            traites++;
+        }
+
+        // Les emplacements ne sont rendus au travailleur qu'une fois leur contenu formate
+        __atomic_store_n(&file->tete, tete, __ATOMIC_RELEASE);
+    }
+
+    if (longueurTampon > 0) {
+        ecrireTampon();
+    }
+
+    return traites;
+}
+
+/**
+ * @brief Corps du thread ecrivain : vide les anneaux, attend quand ils sont vides, rouvre sur demande
+ */
+static void *ecrivainJournal(void *arg) {
+    const struct timespec attente = { 0, ATTENTE_JOURNAL * 1000000L };
+
+    (void) arg;
+
+    for (;;) {
+        if (__atomic_exchange_n(&reouvertureDemandee, 0, __ATOMIC_ACQUIRE)) {
+            rouvrirJournal();
+        }
+
+        // Anneaux vides : une courte pause plutot qu'une attente active
+        if (viderFiles() == 0) {
+            nanosleep(&attente, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+int demarrerJournal(const char *chemin, FormatJournal format, bool bloquant) {
+    pthread_t ecrivain;
+
+    cheminJournal = chemin;
+    formatJournal = format;
+    journalBloquant = bloquant;
+
+    if ((fichierJournal = ouvrirJournal()) < 0) {
+        return 0;
+    }
+
+    if ((tamponJournal = malloc(TAILLE_TAMPON_JOURNAL)) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 0;
+    }
+
+    if ((pthread_create(&ecrivain, NULL, ecrivainJournal, NULL) != 0) || (pthread_detach(ecrivain) != 0)) {
+        fprintf(stderr, "demarrerJournal, impossible de creer l'ecrivain\n");
+        return 0;
+    }
+
+    journalActif = TRUE;
+
+    return 1;
+}
+
+void demanderReouvertureJournal(void) {
+    __atomic_store_n(&reouvertureDemandee, 1, __ATOMIC_RELEASE);
+}
+
+int inscrireJournal(void) {
+    int indice;
+
+    if (!(journalActif)) {
+        return 1;
+    }
+
+    if ((fileLocale = aligned_alloc(TAILLE_LIGNE_CACHE, sizeof(FileJournal))) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 0;
+    }
+
+    memset(fileLocale, 0, sizeof(FileJournal));
+
+    if ((indice = __atomic_fetch_add(&nombreFiles, 1, __ATOMIC_RELAXED)) >= MAX_TRAVAILLEURS_JOURNAL) {
+        fprintf(stderr, "inscrireJournal, trop de travailleurs\n");
+        free(fileLocale);
+        fileLocale = NULL;
+        return 0;
+    }
+
+    __atomic_store_n(&filesJournal[indice], fileLocale, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+/**
+ * @brief Recopie une tranche tronquee et terminee par un zero, vide si elle est absente
+ */
+static void copierTranche(char *destination, size_t maxDestination, const Tranche *tranche) {
+    size_t longueur = 0;
+
+    if (tranche != NULL) {
+        longueur = (tranche->longueur < maxDestination) ? tranche->longueur : maxDestination - 1;
+        memcpy(destination, tranche->debut, longueur);
+    }
+
+    destination[longueur] = '\0';
+}
+
+void journaliserRequete(const Connexion *connexion, const Requete *requete, uint64_t duree) {
+    const struct timespec pause = { 0, 50000 };
+    EnregistrementJournal *enregistrement = NULL;
+    uint64_t queue;
+
+    if (fileLocale == NULL) {
+        return;
+    }
+
+    queue = fileLocale->queue;
+
+    // L'anneau semble plein : on relit la tete de l'ecrivain avant de perdre ou d'attendre
+    if (queue - teteConnue == CAPACITE_JOURNAL) {
+        teteConnue = __atomic_load_n(&fileLocale->tete, __ATOMIC_ACQUIRE);
+
+        while (queue - teteConnue == CAPACITE_JOURNAL) {
+            if (!(journalBloquant)) {
+                compterJournalPerdu();
+                return;
+            }
+            nanosleep(&pause, NULL);
+            teteConnue = __atomic_load_n(&fileLocale->tete, __ATOMIC_ACQUIRE);
+        }
+    }
+
+    // Seule la recopie est faite ici : le formatage et l'ecriture reviennent a l'ecrivain
+    enregistrement = &fileLocale->enregistrements[queue & (CAPACITE_JOURNAL - 1)];
+    clock_gettime(CLOCK_REALTIME, &enregistrement->horodatage);
+    enregistrement->duree = duree;
+    enregistrement->octets = connexion->longueurCorps;
+    enregistrement->statut = connexion->statut;
+    memcpy(enregistrement->client, connexion->client, sizeof(enregistrement->client));
+    copierTranche(enregistrement->methode, sizeof(enregistrement->methode), &requete->methode);
+    copierTranche(enregistrement->cible, sizeof(enregistrement->cible), &requete->cible);
+    copierTranche(enregistrement->version, sizeof(enregistrement->version), &requete->version);
+    copierTranche(enregistrement->referent, sizeof(enregistrement->referent), chercherEntete(requete, "Referer"));
+    copierTranche(enregistrement->agent, sizeof(enregistrement->agent), chercherEntete(requete, "User-Agent"));
+
+    __atomic_store_n(&fileLocale->queue, queue + 1, __ATOMIC_RELEASE);
+}
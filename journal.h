@@ -0,0 +1,99 @@
+/**
+ * @file    journal.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration du journal des acces \n
+ *          Le travailleur ne fait que recopier chaque requete dans un
+ *          enregistrement de taille fixe, dans un anneau qui lui est propre
+ *          (un seul producteur, un seul consommateur, sans verrou). Un thread
+ *          ecrivain formate les enregistrements de tous les anneaux et les
+ *          ecrit par gros blocs : le traitement des requetes n'attend jamais
+ *          le disque. Le fichier est rouvert sur demande (SIGHUP, rotation par logrotate).
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include "serveur.h"
+#include "requete.h"
+
+#include <time.h>
+
+/* Nombre d'enregistrements de l'anneau de chaque travailleur (puissance de 2) */
+#define CAPACITE_JOURNAL 1024
+/* Nombre maximal de travailleurs dont les anneaux sont lus */
+#define MAX_TRAVAILLEURS_JOURNAL 1024
+/* Longueurs gardees des champs recopies de la requete, zero final compris */
+#define LONGUEUR_MAX_METHODE_JOURNAL 16
+#define LONGUEUR_MAX_VERSION_JOURNAL 16
+#define LONGUEUR_MAX_CIBLE_JOURNAL 256
+#define LONGUEUR_MAX_ENTETE_JOURNAL 160
+/* Taille du tampon d'ecriture du thread ecrivain */
+#define TAILLE_TAMPON_JOURNAL (256 * 1024)
+/* Attente du thread ecrivain quand aucun anneau n'a d'enregistrement, en millisecondes */
+#define ATTENTE_JOURNAL 10
+
+/**
+ * @brief Format des lignes du journal
+ */
+typedef enum {
+    FORMAT_COMMUN,          /* Common Log Format */
+    FORMAT_COMBINE,         /* Combined Log Format : CLF suivi du Referer et du User-Agent */
+    FORMAT_JSON             /* un objet JSON par ligne */
+} FormatJournal;
+
+/**
+ * @brief Enregistrement d'une requete, recopie tel quel dans l'anneau
+ */
+typedef struct {
+    struct timespec horodatage;     /* fin du traitement, temps reel */
+    uint64_t duree;                 /* duree du traitement en microsecondes */
+    long long octets;               /* longueur du corps de la reponse, -1 si en flux */
+    int statut;
+    char client[INET6_ADDRSTRLEN];
+    char methode[LONGUEUR_MAX_METHODE_JOURNAL];
+    char version[LONGUEUR_MAX_VERSION_JOURNAL];
+    char cible[LONGUEUR_MAX_CIBLE_JOURNAL];
+    char referent[LONGUEUR_MAX_ENTETE_JOURNAL];
+    char agent[LONGUEUR_MAX_ENTETE_JOURNAL];
+} EnregistrementJournal;
+
+/**
+ * @brief   Ouvre le journal et demarre son thread ecrivain \n
+ *          Note : a appeler avant le demarrage des travailleurs
+ *
+ * @param chemin    Fichier du journal, ouvert en ajout
+ * @param format    Format des lignes
+ * @param bloquant  TRUE pour attendre de la place quand un anneau est plein,
+ *                  FALSE pour perdre l'enregistrement (compte dans les mesures)
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int demarrerJournal(const char *chemin, FormatJournal format, bool bloquant);
+
+/**
+ * @brief   Demande a l'ecrivain de rouvrir le fichier du journal, apres sa rotation \n
+ *          Note : peut etre appelee depuis n'importe quel thread ; sans effet si le journal est inactif
+ */
+void demanderReouvertureJournal(void);
+
+/**
+ * @brief   Cree l'anneau du travailleur courant si le journal est actif \n
+ *          Note : a appeler au demarrage de chaque travailleur
+ *
+ * @return  int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int inscrireJournal(void);
+
+/**
+ * @brief Ajoute une requete traitee a l'anneau du travailleur, sans appel systeme
+ *
+ * @param connexion Connexion du client, pour son adresse et la reponse emise
+ * @param requete   Requete traitee
+ * @param duree     Duree du traitement en microsecondes
+ */
+void journaliserRequete(const Connexion *connexion, const Requete *requete, uint64_t duree);
+
+#endif
@@ -7,136 +7,473 @@
  * 
  * @copyright Copyright (c) 2020
  */
-#include "serveur.h"
+#include "cache.h"
+#include "compression.h"
+#include "erreurs.h"
+#include "journal.h"
+#include "mesures.h"
+#include "mime.h"
+#include "plage.h"
+#include "projection.h"
+#include "racine.h"
+#include "reacteur.h"
+#include "recherche.h"
+#include "trace.h"
+#include "validation.h"
 
-int main() {
-    char *message = NULL;
+#include <pthread.h>
+#include <signal.h>
 
-    // On initialise le service avec ouverture du port
-    Initialisation();
+/**
+ * @brief Emission d'une reponse 304 : la copie du client est toujours valide
+ * 
+ * @param connexion     Connexion du client
+ * @param validateurs   Validateurs de la representation
+ * @param compressible  TRUE si la reponse depend de l'encodage demande
+ */
+static void envoyerNonModifie(Connexion *connexion, const Validateurs *validateurs, bool compressible) {
+    char entetes[TAILLE_MAX_ENTETE];
 
-    while (1) {
-        int fini = 0;
+    if ((formaterValidateurs(entetes, sizeof(entetes), validateurs, entetesEncodage(ENCODAGE_IDENTITE, compressible)) < 0) ||
+        (!(EmissionNonModifie(connexion, entetes)))) {
+        envoyerReponse500(connexion);
+    }
+}
 
-        // On attend une connexion client
-        AttenteClient();
+/**
+ * @brief Emission d'une reponse du cache, entiere ou limitee aux plages demandees
+ * 
+ * @param connexion Connexion du client
+ * @param requete   Requete du client, pour son en-tete Range
+ * @param entree    Reponse du cache a emettre
+ */
+static void envoyerEntree(Connexion *connexion, const Requete *requete, EntreeCache *entree) {
+    Plage plages[MAX_PLAGES];
+    char entetes[TAILLE_MAX_ENTETE];
+    off_t taille = (off_t) (entree->taille - entree->tailleEntete);
+    int nombre = PLAGES_IGNOREES, retour;
 
-        // Tant que le client emet des requetes
-        while (!fini) {
-            if (message != NULL) {
-                free(message);
-                message = NULL;
-            }
+    // Seul un contenu non compresse est decoupe : les plages portent sur les octets du fichier
+    if (entree->encodageCorps == ENCODAGE_IDENTITE) {
+        nombre = analyserPlages(requete, &entree->validateurs, taille, plages);
+    }
 
-            message = Reception();
+    if (nombre == PLAGES_IGNOREES) {
+        retour = envoyerEntreeCache(connexion, entree);
+    } else if (formaterValidateurs(entetes, sizeof(entetes), &entree->validateurs,
+                                   entetesEncodage(ENCODAGE_IDENTITE, entree->compressible)) < 0) {
+        retour = 0;
+    } else if (nombre == PLAGES_INSATISFAISABLES) {
+        retour = envoyerReponse416(connexion, entree->typeContenu, taille, entetes);
+    } else {
+        retour = envoyerPlages(connexion, plages, nombre, taille, entree->typeContenu, entetes, entree);
+    }
 
-            // On verifie que message contient quelque chose
-            if (message != NULL) {
-                char nomFichier[256], extension[5];
+    if (!(retour)) {
+        envoyerReponse500(connexion);
+    }
+}
 
-                // Si la requete n'est pas connue par le serveur on emet une erreur
-                if (!(verifierRequete(message))) {
-                    envoyerReponse500("Erreur serveur : le serveur n'est pas capable de traiter la requete\n");
-                    continue;
-                }
+/**
+ * @brief Emission d'un fichier trouve, depuis le cache si possible
+ * 
+ * @param connexion     Connexion du client
+ * @param requete       Requete du client, pour ses conditions
+ * @param nomFichier    Nom du fichier a envoyer
+ * @param typeContenu   Type MIME du fichier
+ * @param encodage      Encodage negocie avec le client
+ */
+static void envoyerFichier(Connexion *connexion, const Requete *requete, char *nomFichier, char *typeContenu,
+                           Encodage encodage) {
+    EntreeCache *entree = NULL;
+    Validateurs validateurs;
+    Plage plages[MAX_PLAGES];
+    struct stat infos;
+    char variante[PATH_MAX], entetes[TAILLE_MAX_ENTETE];
+    char *source = nomFichier;
+    bool compressible = estCompressible(typeContenu);
+    int nombre = PLAGES_IGNOREES;
 
-                // Si l'extraction du fichier rencontre une erreur on emet un message d'erreur
-                if (!(extraitFichier(message, nomFichier, 256))) {
-                    envoyerReponse500("Erreur serveur : probleme detecte avec le nom du fichier\n");
-                    continue;
-                }
+    if (!(compressible)) {
+        encodage = ENCODAGE_IDENTITE;
+    }
 
-                // Si le fichier n'est pas accessible on emet une erreur 404
-                if (!(verifierAccesFichier(nomFichier))) {
-                    envoyerReponse404HTML("page404.html");
+    // Le fichier emis est la variante precompressee si elle existe
+    if (chercherVariante(nomFichier, encodage, variante, sizeof(variante))) {
+        source = variante;
+    }
 
-                    if (!(envoyerContenuFichierTexte("page404.html"))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie du contenu\n");
-                        continue;
-                    }
+    if (resoudreFichier(source, &infos) < 0) {
+        envoyerReponse500(connexion);
+        return;
+    }
 
-                    continue;
-                }
+    // Un fichier trop gros pour le cache n'est pas compresse a la volee
+    if ((source == nomFichier) && (!(peutMettreEnCache(infos.st_size)))) {
+        encodage = ENCODAGE_IDENTITE;
+    }
 
-                // Si l'extraction de l'extension rencontre un probleme, on emet un message d'erreur
-                if (!(extraitExtension(nomFichier, extension, 5))) {
-                    envoyerReponse500("Erreur serveur : probleme lors de la recherche de l'extension\n");
-                    continue;
-                }
+    // Un stat suffit aux validateurs : une copie encore valide est confirmee sans ouvrir le fichier
+    calculerValidateurs(&infos, encodage, &validateurs);
+    TRACE_PHASE(PHASE_RESOLUTION);
 
-                // En fonction de l'extension trouvee, on emet les reponses et les fichiers correspondants
-                // Chaque appel de fonction est soumis au controle d'erreur avec emission d'un message si probleme
-                if (!(strcmp(extension, "html"))) {
-                    if (!(envoyerReponse200HTML(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie de la reponse\n");
-                        continue;
-                    }
-
-                    if (!(envoyerContenuFichierTexte(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie du contenu\n");
-                        continue;
-                    }
-                } else if (!(strcmp(extension, "css"))) {
-                    if (!(envoyerReponse200CSS(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie de la reponse\n");
-                        continue;
-                    }
-
-                    if (!(envoyerContenuFichierTexte(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie du contenu\n");
-                        continue;
-                    }
-                } else if (!(strcmp(extension, "js"))) {
-                    if (!(envoyerReponse200JS(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie de la reponse\n");
-                        continue;
-                    }
-
-                    if (!(envoyerContenuFichierTexte(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie du contenu\n");
-                        continue;
-                    }
-                } else if ((!(strcmp(extension, "jpg"))) || (!(strcmp(extension, "jpeg")))) {
-                    if (!(envoyerReponse200JPG(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie de la reponse\n");
-                        continue;
-                    }
-
-                    if (!(envoyerContenuFichierBinaire(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie du contenu\n");
-                        continue;
-                    }
-                } else if (!(strcmp(extension, "ico"))) {
-                    if (!(envoyerReponse200ICO(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie de la reponse\n");
-                        continue;
-                    }
-
-                    if (!(envoyerContenuFichierBinaire(nomFichier))) {
-                        envoyerReponse500("Erreur serveur : probleme rencontre lors de l'envoie du contenu\n");
-                        continue;
-                    }
-                } else {
-                    fprintf(stderr, "Erreur : extension inconnue\n");
-                    envoyerReponse500("Erreur serveur : extension de fichier inconnue\n");
-                    continue;
-                }
+    if (estNonModifie(requete, &validateurs)) {
+        envoyerNonModifie(connexion, &validateurs, compressible);
+        return;
+    }
+
+    // Les petits fichiers sont lus (et compresses) une fois puis servis depuis la memoire
+    if ((entree = mettreEnCache(nomFichier, typeContenu, encodage)) != NULL) {
+        envoyerEntree(connexion, requete, entree);
+        return;
+    }
+
+    // Hors du cache, le fichier d'origine part tel quel : ni Content-Encoding ni ETag d'une compression
+    if ((source == nomFichier) && (encodage != ENCODAGE_IDENTITE)) {
+        encodage = ENCODAGE_IDENTITE;
+        calculerValidateurs(&infos, encodage, &validateurs);
+    }
+
+    if (formaterValidateurs(entetes, sizeof(entetes), &validateurs, entetesEncodage(encodage, compressible)) < 0) {
+        envoyerReponse500(connexion);
+        return;
+    }
+
+    // Les gros fichiers sont servis tels quels : seules les plages demandees sont lues
+    if (source == nomFichier) {
+        nombre = analyserPlages(requete, &validateurs, infos.st_size, plages);
+    }
+
+    if (nombre == PLAGES_INSATISFAISABLES) {
+        if (!(envoyerReponse416(connexion, typeContenu, infos.st_size, entetes))) {
+            envoyerReponse500(connexion);
+        }
+        return;
+    }
+
+    if (nombre > 0) {
+        if ((!(ouvrirFichierSortie(connexion, source, NULL))) ||
+            (!(envoyerPlages(connexion, plages, nombre, infos.st_size, typeContenu, entetes, NULL)))) {
+            envoyerReponse500(connexion);
+        }
+        return;
+    }
+
+    if (!(envoyerReponse200(connexion, typeContenu, infos.st_size, entetes))) {
+        envoyerReponse500(connexion);
+        return;
+    }
+
+    if (!(envoyerContenuFichier(connexion, source))) {
+        envoyerReponse500(connexion);
+        return;
+    }
+}
+
+/**
+ * @brief Traitement d'une requete complete recue par le reacteur
+ * 
+ * @param connexion Connexion du client qui a emis la requete
+ * @param requete   Requete analysee
+ */
+static void traiterRequete(Connexion *connexion, const Requete *requete) {
+    char nomFichier[256], extension[TAILLE_MAX_EXTENSION];
+    char *typeContenu = NULL;
+    EntreeCache *entree = NULL;
+    Encodage encodage;
+
+    // Le corps d'une requete n'est pas lu : la connexion est fermee apres la reponse
+    if (porteCorps(requete)) {
+        envoyerErreur(connexion, ERREUR_413);
+        return;
+    }
+
+    if (!(trancheEgale(&requete->methode, "GET"))) {
+        envoyerErreur(connexion, ERREUR_405);
+        return;
+    }
+
+    // Une erreur ne coute qu'un segment de sortie : la reponse est preparee au demarrage
+    if ((!(verifierRequete(requete))) || (!(extraitFichier(requete, nomFichier, 256)))) {
+        envoyerErreur(connexion, ERREUR_400);
+        return;
+    }
+
+    // Les mesures de tous les travailleurs ne sont additionnees qu'a leur lecture
+    if (!(strcmp(nomFichier, CHEMIN_MESURES))) {
+        if (!(envoyerMesures(connexion))) {
+            envoyerReponse500(connexion);
+        }
+        return;
+    }
+
+#ifdef TRACAGE
+    if (!(strcmp(nomFichier, CHEMIN_TRACE))) {
+        if (!(envoyerTraces(connexion))) {
+            envoyerReponse500(connexion);
+        }
+        return;
+    }
+#endif
+
+    compterFichier(nomFichier);
+    TRACE_PHASE(PHASE_VERIFICATION);
+
+    encodage = negocierEncodage(requete);
+
+    // Une reponse deja en cache est emise telle quelle, sans toucher au disque
+    entree = chercherCache(nomFichier, encodage);
+    TRACE_PHASE(PHASE_CACHE);
+
+    if (entree != NULL) {
+        if (estNonModifie(requete, &entree->validateurs)) {
+            envoyerNonModifie(connexion, &entree->validateurs, entree->compressible);
+        } else {
+            envoyerEntree(connexion, requete, entree);
+        }
+        return;
+    }
+
+    // Si le fichier n'est pas accessible on emet une erreur 404
+    if (!(verifierAccesFichier(nomFichier))) {
+        TRACE_PHASE(PHASE_RESOLUTION);
+        envoyerErreur(connexion, ERREUR_404);
+        return;
+    }
+
+    // Un fichier sans extension ou d'extension inconnue est servi comme une suite d'octets
+    if ((!(extraitExtension(nomFichier, extension, TAILLE_MAX_EXTENSION))) ||
+        ((typeContenu = chercherTypeMime(extension)) == NULL)) {
+        typeContenu = TYPE_MIME_DEFAUT;
+    }
+
+    TRACE_PHASE(PHASE_RESOLUTION);
+    envoyerFichier(connexion, requete, nomFichier, typeContenu, encodage);
+}
+
+/**
+ * @brief Corps du thread des signaux : SIGHUP fait rouvrir le journal et relire les pages d'erreur
+ */
+static void *attendreSignaux(void *arg) {
+    const sigset_t *signaux = arg;
+    int signal;
 
-                free(message);
-                message = NULL;
-            } else {
-                fini = 1;
-            }
+    for (;;) {
+        if ((sigwait(signaux, &signal) == 0) && (signal == SIGHUP)) {
+            demanderReouvertureJournal();
+            rechargerErreurs();
         }
+    }
+
+    return NULL;
+}
 
-        // On ferme la connexion avec le client lorsqu'il n'y a plus de requete a traiter
-        TerminaisonClient();
+/**
+ * @brief   Bloque SIGHUP dans tout le processus et demarre le thread qui l'attend \n
+ *          Note : a appeler avant de creer tout autre thread, qui herite du masque
+ *
+ * @return  int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+static int demarrerSignaux(void) {
+    static sigset_t signaux;
+    pthread_t attente;
+
+    sigemptyset(&signaux);
+    sigaddset(&signaux, SIGHUP);
+    if (pthread_sigmask(SIG_BLOCK, &signaux, NULL) != 0) {
+        fprintf(stderr, "demarrerSignaux, impossible de bloquer SIGHUP\n");
+        return 0;
     }
 
-    if (message != NULL) {
-        free(message);
-        message = NULL;
+    if ((pthread_create(&attente, NULL, attendreSignaux, &signaux) != 0) || (pthread_detach(attente) != 0)) {
+        fprintf(stderr, "demarrerSignaux, impossible de creer le thread des signaux\n");
+        return 0;
     }
 
-    return 0;
+    return 1;
+}
+
+/**
+ * @brief Affiche la syntaxe de la ligne de commande
+ */
+static void usage(char *programme) {
+    fprintf(stderr, "Usage : %s [-p port] [-t travailleurs] [-c cache en Kio] [-m fichier mime.types]\n"
+                    "        [-k inactivite en s] [-i entetes en s] [-w emission en s] [-e epoll|io_uring]\n"
+                    "        [-a max-age en s] [-r racine] [-s sendfile|mmap] [-l journal des acces]\n"
+                    "        [-f clf|combined|json] [-b] [-q file d'attente] [-n connexions max]\n", programme);
+}
+
+int main(int argc, char *argv[]) {
+    char *service = "13214";
+    long nombreTravailleurs = sysconf(_SC_NPROCESSORS_ONLN);
+    long budgetCache = BUDGET_CACHE_DEFAUT / 1024;
+    char *fichierMime = FICHIER_MIME_DEFAUT;
+    long delaiInactivite = DELAI_INACTIVITE_DEFAUT;
+    long delaiEntetes = DELAI_ENTETES_DEFAUT;
+    long delaiEmission = DELAI_EMISSION_DEFAUT;
+    MoteurReacteur moteur = MOTEUR_EPOLL;
+    long dureeCacheClient = DUREE_CACHE_CLIENT_DEFAUT;
+    char *racine = RACINE_DEFAUT;
+    size_t budgetProjections = 0;
+    char *fichierJournal = NULL;
+    FormatJournal formatJournal = FORMAT_COMBINE;
+    bool journalBloquant = FALSE;
+    long backlog = SOMAXCONN;
+    long maxConnexions = 0;
+    int option;
+
+    while ((option = getopt(argc, argv, "p:t:c:m:k:i:w:e:a:r:s:l:f:bq:n:")) != -1) {
+        switch (option) {
+            case 'p':
+                service = optarg;
+                break;
+            case 't':
+                nombreTravailleurs = strtol(optarg, NULL, 10);
+                break;
+            case 'c':
+                budgetCache = strtol(optarg, NULL, 10);
+                break;
+            case 'm':
+                fichierMime = optarg;
+                break;
+            case 'k':
+                delaiInactivite = strtol(optarg, NULL, 10);
+                break;
+            case 'i':
+                delaiEntetes = strtol(optarg, NULL, 10);
+                break;
+            case 'w':
+                delaiEmission = strtol(optarg, NULL, 10);
+                break;
+            case 'a':
+                dureeCacheClient = strtol(optarg, NULL, 10);
+                break;
+            case 'r':
+                racine = optarg;
+                break;
+            case 's':
+                // Les gros fichiers sont emis depuis une projection partagee plutot que par sendfile
+                if (!(strcmp(optarg, "mmap"))) {
+                    budgetProjections = BUDGET_PROJECTIONS_DEFAUT;
+                } else if (strcmp(optarg, "sendfile") != 0) {
+                    fprintf(stderr, "Mode d'envoi %s inconnu\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'l':
+                fichierJournal = optarg;
+                break;
+            case 'f':
+                if (!(strcmp(optarg, "clf"))) {
+                    formatJournal = FORMAT_COMMUN;
+                } else if (!(strcmp(optarg, "json"))) {
+                    formatJournal = FORMAT_JSON;
+                } else if (strcmp(optarg, "combined") != 0) {
+                    fprintf(stderr, "Format de journal %s inconnu\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'b':
+                // Anneau plein : le travailleur attend l'ecrivain plutot que de perdre la ligne
+                journalBloquant = TRUE;
+                break;
+            case 'q':
+                backlog = strtol(optarg, NULL, 10);
+                break;
+            case 'n':
+                maxConnexions = strtol(optarg, NULL, 10);
+                break;
+            case 'e':
+                if (!(strcmp(optarg, "io_uring"))) {
+                    moteur = MOTEUR_IO_URING;
+                } else if (strcmp(optarg, "epoll") != 0) {
+                    fprintf(stderr, "Moteur %s inconnu\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if ((nombreTravailleurs < 1) || (nombreTravailleurs > 1024)) {
+        fprintf(stderr, "Nombre de travailleurs invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (budgetCache < 0) {
+        fprintf(stderr, "Budget de cache invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if ((delaiInactivite < 1) || (delaiInactivite > DELAI_MAXIMAL)) {
+        fprintf(stderr, "Delai d'inactivite invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if ((delaiEntetes < 1) || (delaiEntetes > DELAI_MAXIMAL)) {
+        fprintf(stderr, "Delai de reception des entetes invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if ((delaiEmission < 1) || (delaiEmission > DELAI_MAXIMAL)) {
+        fprintf(stderr, "Delai d'emission invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if ((backlog < 1) || (backlog > INT_MAX)) {
+        fprintf(stderr, "File d'attente invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if ((maxConnexions < 0) || (maxConnexions > INT_MAX)) {
+        fprintf(stderr, "Nombre de connexions invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (dureeCacheClient < 0) {
+        fprintf(stderr, "Duree de cache client invalide\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Tous les fichiers servis sont resolus sous la racine, ouverte une fois pour toutes
+    if (!(configurerRacine(racine))) {
+        return 1;
+    }
+
+    // SIGHUP est bloque avant la creation des threads : seul le thread des signaux le recoit
+    if (!(demarrerSignaux())) {
+        return 1;
+    }
+
+    if ((fichierJournal != NULL) && (!(demarrerJournal(fichierJournal, formatJournal, journalBloquant)))) {
+        return 1;
+    }
+
+    TRACE_INITIALISER();
+    configurerAdmission((int) backlog, (int) maxConnexions);
+    configurerCache((size_t) budgetCache * 1024);
+    configurerProjections(budgetProjections);
+    configurerValidation(dureeCacheClient);
+    configurerReacteur((int) delaiInactivite, (int) delaiEntetes, (int) delaiEmission);
+    configurerMoteur(moteur);
+    chargerTypesMime(fichierMime);
+    printf("Recherche dans les requetes : %s.\n", nomRecherche(initialiserRecherche(RECHERCHE_AVX2)));
+
+    // Chaque travailleur ouvre le port et sert ses clients jusqu'a l'arret du serveur
+    lancerTravailleurs(service, (int) nombreTravailleurs, traiterRequete);
+
+    return 1;
 }
@@ -0,0 +1,482 @@
+/**
+ * @file    mesures.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source des mesures du serveur \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "mesures.h"
+
+#include <time.h>
+
+/* Compteurs du travailleur : il est seul a les ecrire, la lecture d'un autre thread est relachee */
+#define AJOUTER(compteur, valeur) \
+    __atomic_store_n(&(compteur), __atomic_load_n(&(compteur), __ATOMIC_RELAXED) + (valeur), __ATOMIC_RELAXED)
+#define LIRE(compteur) __atomic_load_n(&(compteur), __ATOMIC_RELAXED)
+
+/* Extensions comptees separement, dans l'ordre des cases ; les autres vont dans la derniere */
+static const char *extensionsMesurees[NOMBRE_EXTENSIONS_MESUREES - 1] = {
+    "html", "css", "js", "json", "png", "jpg", "jpeg", "gif", "svg", "ico", "webp", "woff2", "txt", "pdf", "mp4"
+};
+
+/* Libelles des delais des connexions, dans l'ordre de EcheanceConnexion */
+static const char *nomsEcheances[NOMBRE_ECHEANCES] = {
+    "aucune", "header", "idle", "write"
+};
+
+/* Compteurs de tous les travailleurs inscrits, lus par /__metrics */
+static Mesures *mesuresTravailleurs[MAX_TRAVAILLEURS_MESURES];
+static int nombreInscrits;
+
+/* Compteurs du travailleur courant */
+static _Thread_local Mesures mesuresLocales;
+
+int inscrireMesures(void) {
+    int indice = __atomic_fetch_add(&nombreInscrits, 1, __ATOMIC_RELAXED);
+
+    if (indice >= MAX_TRAVAILLEURS_MESURES) {
+        fprintf(stderr, "inscrireMesures, trop de travailleurs\n");
+        return 0;
+    }
+
+    // Les compteurs d'un thread vivent aussi longtemps que lui, c'est-a-dire autant que le serveur
+    __atomic_store_n(&mesuresTravailleurs[indice], &mesuresLocales, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+uint64_t instantUs(void) {
+    struct timespec maintenant;
+
+    clock_gettime(CLOCK_MONOTONIC, &maintenant);
+
+    return (uint64_t) maintenant.tv_sec * 1000000 + (uint64_t) maintenant.tv_nsec / 1000;
+}
+
+size_t intervalleLatence(uint64_t duree) {
+    unsigned int exposant;
+    size_t indice;
+
+    if (duree < (2u << BITS_SOUS_INTERVALLE)) {
+        return (size_t) duree;
+    }
+
+    // Les bits qui suivent le bit de poids fort choisissent le sous-intervalle, comme HdrHistogram
+    exposant = 63u - (unsigned int) __builtin_clzll(duree);
+    indice = ((size_t) (exposant - BITS_SOUS_INTERVALLE + 1) << BITS_SOUS_INTERVALLE) |
+             (size_t) ((duree >> (exposant - BITS_SOUS_INTERVALLE)) & ((1u << BITS_SOUS_INTERVALLE) - 1));
+
+    return (indice < NOMBRE_INTERVALLES_LATENCE) ? indice : NOMBRE_INTERVALLES_LATENCE - 1;
+}
+
+uint64_t finIntervalle(size_t indice) {
+    unsigned int exposant;
+    uint64_t largeur;
+
+    if (indice < (2u << BITS_SOUS_INTERVALLE)) {
+        return (uint64_t) indice + 1;
+    }
+
+    exposant = (unsigned int) (indice >> BITS_SOUS_INTERVALLE) + BITS_SOUS_INTERVALLE - 1;
+    largeur = (uint64_t) 1 << (exposant - BITS_SOUS_INTERVALLE);
+
+    return (((uint64_t) 1 << exposant) | ((indice & ((1u << BITS_SOUS_INTERVALLE) - 1)) * largeur)) + largeur;
+}
+
+uint64_t mesurerRequete(int statut, uint64_t debut) {
+    uint64_t duree = instantUs() - debut;
+
+    if ((statut >= PREMIER_CODE_STATUT) && (statut < PREMIER_CODE_STATUT + NOMBRE_CODES_STATUT)) {
+        AJOUTER(mesuresLocales.requetes[statut - PREMIER_CODE_STATUT], 1);
+    }
+
+    AJOUTER(mesuresLocales.latences[intervalleLatence(duree)], 1);
+    AJOUTER(mesuresLocales.sommeLatences, duree);
+
+    return duree;
+}
+
+void compterFichier(const char *nomFichier) {
+    const char *point = strrchr(nomFichier, '.');
+    size_t i = 0;
+
+    if ((point != NULL) && (strchr(point, '/') == NULL)) {
+        while ((i < NOMBRE_EXTENSIONS_MESUREES - 1) && (strcasecmp(point + 1, extensionsMesurees[i]) != 0)) {
+            i++;
+        }
+    } else {
+        i = NOMBRE_EXTENSIONS_MESUREES - 1;
+    }
+
+    AJOUTER(mesuresLocales.extensions[i], 1);
+}
+
+void compterOctetsEmis(size_t octets) {
+    AJOUTER(mesuresLocales.octetsEmis, octets);
+}
+
+void compterOuverture(void) {
+    AJOUTER(mesuresLocales.connexionsOuvertes, 1);
+}
+
+void compterFermeture(void) {
+    AJOUTER(mesuresLocales.connexionsFermees, 1);
+}
+
+void compterAcceptationEchouee(void) {
+    AJOUTER(mesuresLocales.acceptationsEchouees, 1);
+}
+
+void compterRefus(void) {
+    AJOUTER(mesuresLocales.refus, 1);
+}
+
+void compterPauseAcceptation(void) {
+    AJOUTER(mesuresLocales.pausesAcceptation, 1);
+}
+
+void compterExpiration(EcheanceConnexion echeance) {
+    AJOUTER(mesuresLocales.expirations[echeance], 1);
+}
+
+void compterCache(bool succes) {
+    if (succes) {
+        AJOUTER(mesuresLocales.succesCache, 1);
+    } else {
+        AJOUTER(mesuresLocales.echecsCache, 1);
+    }
+}
+
+void compterDescripteur(EvenementDescripteur evenement) {
+    AJOUTER(mesuresLocales.descripteurs[evenement], 1);
+}
+
+void compterJournalPerdu(void) {
+    AJOUTER(mesuresLocales.journalPerdus, 1);
+}
+
+/**
+ * @brief Additionne les compteurs de tous les travailleurs inscrits
+ */
+static void additionnerMesures(Mesures *total) {
+    int nombre = __atomic_load_n(&nombreInscrits, __ATOMIC_RELAXED);
+    Mesures *mesures = NULL;
+    int i;
+    size_t j;
+
+    memset(total, 0, sizeof(Mesures));
+
+    if (nombre > MAX_TRAVAILLEURS_MESURES) {
+        nombre = MAX_TRAVAILLEURS_MESURES;
+    }
+
+    for (i = 0; i < nombre; i++) {
+        // Un travailleur en cours d'inscription n'a encore rien compte
+        if ((mesures = __atomic_load_n(&mesuresTravailleurs[i], __ATOMIC_ACQUIRE)) == NULL) {
+            continue;
+        }
+
+        for (j = 0; j < NOMBRE_CODES_STATUT; j++) {
+            total->requetes[j] += LIRE(mesures->requetes[j]);
+        }
+        for (j = 0; j < NOMBRE_EXTENSIONS_MESUREES; j++) {
+            total->extensions[j] += LIRE(mesures->extensions[j]);
+        }
+        for (j = 0; j < NOMBRE_INTERVALLES_LATENCE; j++) {
+            total->latences[j] += LIRE(mesures->latences[j]);
+        }
+        total->sommeLatences += LIRE(mesures->sommeLatences);
+        total->octetsEmis += LIRE(mesures->octetsEmis);
+        total->connexionsOuvertes += LIRE(mesures->connexionsOuvertes);
+        total->connexionsFermees += LIRE(mesures->connexionsFermees);
+        total->acceptationsEchouees += LIRE(mesures->acceptationsEchouees);
+        total->refus += LIRE(mesures->refus);
+        total->pausesAcceptation += LIRE(mesures->pausesAcceptation);
+        for (j = 0; j < NOMBRE_ECHEANCES; j++) {
+            total->expirations[j] += LIRE(mesures->expirations[j]);
+        }
+        total->succesCache += LIRE(mesures->succesCache);
+        total->echecsCache += LIRE(mesures->echecsCache);
+        for (j = 0; j < NOMBRE_EVENEMENTS_DESCRIPTEUR; j++) {
+            total->descripteurs[j] += LIRE(mesures->descripteurs[j]);
+        }
+        total->journalPerdus += LIRE(mesures->journalPerdus);
+    }
+}
+
+/**
+ * @brief   Lit les debordements de la file d'acceptation comptes par le noyau \n
+ *          Note : ces compteurs couvrent toute la machine, pas seulement le serveur
+ *
+ * @return  bool -> Retourne FALSE si /proc/net/netstat est illisible
+ */
+static bool lireDebordementsEcoute(unsigned long long *debordements, unsigned long long *rejets) {
+    char noms[4096], valeurs[4096];
+    char *nom = NULL, *valeur = NULL, *repriseNoms = NULL, *repriseValeurs = NULL;
+    FILE *fichier = NULL;
+    bool trouve = FALSE;
+
+    if ((fichier = fopen("/proc/net/netstat", "r")) == NULL) {
+        return FALSE;
+    }
+
+    // Chaque groupe tient sur deux lignes : les noms des compteurs, puis leurs valeurs
+    while ((!(trouve)) && (fgets(noms, sizeof(noms), fichier) != NULL) &&
+           (fgets(valeurs, sizeof(valeurs), fichier) != NULL)) {
+        if (strncmp(noms, "TcpExt:", 7) != 0) {
+            continue;
+        }
+
+        nom = strtok_r(noms, " \n", &repriseNoms);
+        valeur = strtok_r(valeurs, " \n", &repriseValeurs);
+        while ((nom != NULL) && (valeur != NULL)) {
+            if (!(strcmp(nom, "ListenOverflows"))) {
+                *debordements = strtoull(valeur, NULL, 10);
+            } else if (!(strcmp(nom, "ListenDrops"))) {
+                *rejets = strtoull(valeur, NULL, 10);
+            }
+            nom = strtok_r(NULL, " \n", &repriseNoms);
+            valeur = strtok_r(NULL, " \n", &repriseValeurs);
+        }
+        trouve = TRUE;
+    }
+
+    fclose(fichier);
+
+    return trouve;
+}
+
+/**
+ * @brief Parties successives de la page des mesures, produites element par element
+ */
+typedef enum {
+    PARTIE_REQUETES,
+    PARTIE_EXTENSIONS,
+    PARTIE_EXPIRATIONS,
+    PARTIE_LATENCES,
+    PARTIE_COMPTEURS,
+    PARTIE_DESCRIPTEURS,
+    NOMBRE_PARTIES
+} PartieMesures;
+
+/**
+ * @brief   Etat de la production de la page des mesures \n
+ *          Note : les compteurs sont additionnes une fois, avant l'entete de la reponse
+ */
+typedef struct {
+    Mesures total;
+    PartieMesures partie;
+    size_t indice;              /* element en cours : 0 pour l'aide de la partie, puis ses lignes */
+    unsigned long long cumul;   /* requetes des intervalles de latence deja produits */
+} PageMesures;
+
+/**
+ * @brief Formate l'element en cours de la page, comme snprintf
+ *
+ * @return int -> Retourne la longueur de l'element (0 s'il n'a pas de ligne), -1 quand la partie est finie
+ */
+static int formaterElement(const PageMesures *page, char *destination, size_t capacite) {
+    const Mesures *total = &page->total;
+    unsigned long long debordements = 0, rejets = 0, fin;
+    uint64_t recherches = total->succesCache + total->echecsCache;
+    uint64_t resolutions = total->descripteurs[DESCRIPTEUR_TROUVE] + total->descripteurs[DESCRIPTEUR_RESOLU];
+    size_t i = page->indice - 1;
+
+    switch (page->partie) {
+        case PARTIE_REQUETES:
+            if (page->indice == 0) {
+                return snprintf(destination, capacite, "# HELP http_requests_total Requetes traitees par code de statut.\n"
+                                                       "# TYPE http_requests_total counter\n");
+            } else if (i >= NOMBRE_CODES_STATUT) {
+                return -1;
+            }
+            return (total->requetes[i] == 0) ? 0 :
+                   snprintf(destination, capacite, "http_requests_total{code=\"%zu\"} %llu\n", i + PREMIER_CODE_STATUT,
+                            (unsigned long long) total->requetes[i]);
+        case PARTIE_EXTENSIONS:
+            if (page->indice == 0) {
+                return snprintf(destination, capacite,
+                                "# HELP http_requests_by_extension_total Requetes par extension du fichier demande.\n"
+                                "# TYPE http_requests_by_extension_total counter\n");
+            } else if (i >= NOMBRE_EXTENSIONS_MESUREES) {
+                return -1;
+            }
+            return snprintf(destination, capacite, "http_requests_by_extension_total{extension=\"%s\"} %llu\n",
+                            (i < NOMBRE_EXTENSIONS_MESUREES - 1) ? extensionsMesurees[i] : "autre",
+                            (unsigned long long) total->extensions[i]);
+        case PARTIE_EXPIRATIONS:
+            if (page->indice == 0) {
+                return snprintf(destination, capacite,
+                                "# HELP http_connection_timeouts_total Connexions fermees par delai ecoule.\n"
+                                "# TYPE http_connection_timeouts_total counter\n");
+            } else if (i + ECHEANCE_ENTETES >= NOMBRE_ECHEANCES) {
+                return -1;
+            }
+            return snprintf(destination, capacite, "http_connection_timeouts_total{phase=\"%s\"} %llu\n",
+                            nomsEcheances[i + ECHEANCE_ENTETES],
+                            (unsigned long long) total->expirations[i + ECHEANCE_ENTETES]);
+        case PARTIE_LATENCES:
+            if (page->indice == 0) {
+                return snprintf(destination, capacite,
+                                "# HELP http_request_duration_seconds Duree de traitement des requetes.\n"
+                                "# TYPE http_request_duration_seconds histogram\n");
+            } else if (i >= NOMBRE_INTERVALLES_LATENCE) {
+                return -1;
+            }
+
+            // Les intervalles sont cumulatifs ; le dernier, ouvert, n'apparait qu'en +Inf
+            if (i < NOMBRE_INTERVALLES_LATENCE - 1) {
+                fin = finIntervalle(i);
+                return snprintf(destination, capacite, "http_request_duration_seconds_bucket{le=\"%llu.%06llu\"} %llu\n",
+                                fin / 1000000, fin % 1000000, page->cumul + total->latences[i]);
+            }
+            return snprintf(destination, capacite,
+                            "http_request_duration_seconds_bucket{le=\"+Inf\"} %llu\n"
+                            "http_request_duration_seconds_sum %llu.%06llu\n"
+                            "http_request_duration_seconds_count %llu\n",
+                            page->cumul + total->latences[i], (unsigned long long) (total->sommeLatences / 1000000),
+                            (unsigned long long) (total->sommeLatences % 1000000), page->cumul + total->latences[i]);
+        case PARTIE_COMPTEURS:
+            if (page->indice > 0) {
+                return -1;
+            }
+
+            lireDebordementsEcoute(&debordements, &rejets);
+
+            return snprintf(destination, capacite,
+                            "# HELP http_response_bytes_total Octets envoyes aux clients.\n"
+                            "# TYPE http_response_bytes_total counter\n"
+                            "http_response_bytes_total %llu\n"
+                            "# HELP http_connections_active Connexions ouvertes.\n"
+                            "# TYPE http_connections_active gauge\n"
+                            "http_connections_active %llu\n"
+                            "# HELP http_connections_accepted_total Connexions acceptees.\n"
+                            "# TYPE http_connections_accepted_total counter\n"
+                            "http_connections_accepted_total %llu\n"
+                            "# HELP http_accept_errors_total Acceptations de clients en echec.\n"
+                            "# TYPE http_accept_errors_total counter\n"
+                            "http_accept_errors_total %llu\n"
+                            "# HELP http_connections_rejected_total Clients refuses en surcharge par une reponse 503.\n"
+                            "# TYPE http_connections_rejected_total counter\n"
+                            "http_connections_rejected_total %llu\n"
+                            "# HELP http_accept_pauses_total Suspensions des acceptations, descripteurs ou memoire epuises.\n"
+                            "# TYPE http_accept_pauses_total counter\n"
+                            "http_accept_pauses_total %llu\n"
+                            "# HELP tcp_listen_overflows_total File d'acceptation pleine (toute la machine).\n"
+                            "# TYPE tcp_listen_overflows_total counter\n"
+                            "tcp_listen_overflows_total %llu\n"
+                            "# HELP tcp_listen_drops_total Connexions abandonnees a l'acceptation (toute la machine).\n"
+                            "# TYPE tcp_listen_drops_total counter\n"
+                            "tcp_listen_drops_total %llu\n"
+                            "# HELP http_cache_hits_total Reponses trouvees dans le cache.\n"
+                            "# TYPE http_cache_hits_total counter\n"
+                            "http_cache_hits_total %llu\n"
+                            "# HELP http_cache_misses_total Reponses absentes du cache.\n"
+                            "# TYPE http_cache_misses_total counter\n"
+                            "http_cache_misses_total %llu\n"
+                            "# HELP http_cache_hit_ratio Part des recherches trouvees dans le cache.\n"
+                            "# TYPE http_cache_hit_ratio gauge\n"
+                            "http_cache_hit_ratio %.4f\n"
+                            "# HELP http_access_log_dropped_total Lignes du journal des acces perdues.\n"
+                            "# TYPE http_access_log_dropped_total counter\n"
+                            "http_access_log_dropped_total %llu\n",
+                            (unsigned long long) total->octetsEmis,
+                            (unsigned long long) (total->connexionsOuvertes - total->connexionsFermees),
+                            (unsigned long long) total->connexionsOuvertes,
+                            (unsigned long long) total->acceptationsEchouees, (unsigned long long) total->refus,
+                            (unsigned long long) total->pausesAcceptation, debordements, rejets,
+                            (unsigned long long) total->succesCache, (unsigned long long) total->echecsCache,
+                            (recherches > 0) ? (double) total->succesCache / (double) recherches : 0.0,
+                            (unsigned long long) total->journalPerdus);
+        case PARTIE_DESCRIPTEURS:
+            if (page->indice > 0) {
+                return -1;
+            }
+
+            return snprintf(destination, capacite,
+                            "# HELP http_open_file_cache_hits_total Resolutions de fichiers servies par le cache de descripteurs.\n"
+                            "# TYPE http_open_file_cache_hits_total counter\n"
+                            "http_open_file_cache_hits_total %llu\n"
+                            "# HELP http_open_file_cache_misses_total Resolutions de fichiers faites sur le disque.\n"
+                            "# TYPE http_open_file_cache_misses_total counter\n"
+                            "http_open_file_cache_misses_total %llu\n"
+                            "# HELP http_open_file_cache_hit_ratio Part des resolutions servies par le cache de descripteurs.\n"
+                            "# TYPE http_open_file_cache_hit_ratio gauge\n"
+                            "http_open_file_cache_hit_ratio %.4f\n"
+                            "# HELP http_open_file_cache_invalidations_total Resolutions perimees, par inotify ou expiration.\n"
+                            "# TYPE http_open_file_cache_invalidations_total counter\n"
+                            "http_open_file_cache_invalidations_total %llu\n"
+                            "# HELP http_open_file_cache_evictions_total Resolutions evincees faute de place.\n"
+                            "# TYPE http_open_file_cache_evictions_total counter\n"
+                            "http_open_file_cache_evictions_total %llu\n",
+                            (unsigned long long) total->descripteurs[DESCRIPTEUR_TROUVE],
+                            (unsigned long long) total->descripteurs[DESCRIPTEUR_RESOLU],
+                            (resolutions > 0) ? (double) total->descripteurs[DESCRIPTEUR_TROUVE] / (double) resolutions : 0.0,
+                            (unsigned long long) total->descripteurs[DESCRIPTEUR_INVALIDE],
+                            (unsigned long long) total->descripteurs[DESCRIPTEUR_EVINCE]);
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Produit la suite de la page des mesures au format texte de Prometheus, element par element
+ */
+static ssize_t produireMesures(void *contexte, char *destination, size_t capacite) {
+    PageMesures *page = contexte;
+    size_t longueur = 0;
+    int ecrit;
+
+    while (page->partie < NOMBRE_PARTIES) {
+        if ((ecrit = formaterElement(page, &destination[longueur], capacite - longueur)) < 0) {
+            page->partie++;
+            page->indice = 0;
+            continue;
+        }
+
+        // L'element qui ne tient plus dans ce morceau commencera le suivant
+        if ((size_t) ecrit >= capacite - longueur) {
+            if (longueur == 0) {
+                fprintf(stderr, "Erreur : element des mesures plus long qu'un morceau\n");
+                return -1;
+            }
+            break;
+        }
+
+        if ((page->partie == PARTIE_LATENCES) && (page->indice > 0)) {
+            page->cumul += page->total.latences[page->indice - 1];
+        }
+
+        longueur += (size_t) ecrit;
+        page->indice++;
+    }
+
+    return (ssize_t) longueur;
+}
+
+int envoyerMesures(Connexion *connexion) {
+    PageMesures *page = NULL;
+
+    // Les compteurs sont alignes sur une ligne de cache, leur copie aussi
+    if ((page = aligned_alloc(TAILLE_LIGNE_CACHE, sizeof(PageMesures))) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 0;
+    }
+
+    // La somme n'est faite qu'ici : le chemin des requetes n'ecrit que dans ses propres compteurs
+    additionnerMesures(&page->total);
+    page->partie = PARTIE_REQUETES;
+    page->indice = 0;
+    page->cumul = 0;
+
+    // La page part en morceaux a mesure qu'elle est formatee, sans limite de taille
+    return EmissionFlux(connexion, "200 OK", "text/plain; version=0.0.4", "Cache-Control: no-store\r\n",
+                        produireMesures, page, free);
+}
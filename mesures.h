@@ -0,0 +1,186 @@
+/**
+ * @file    mesures.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration des mesures du serveur \n
+ *          Chaque travailleur tient ses propres compteurs, alignes sur une
+ *          ligne de cache : il est seul a les ecrire, sans verrou ni
+ *          instruction atomique couteuse. Ils ne sont additionnes qu'a la
+ *          lecture de /__metrics, au format texte de Prometheus.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __MESURES_H__
+#define __MESURES_H__
+
+#include "serveur.h"
+
+/* Chemin normalise de la page des mesures */
+#define CHEMIN_MESURES "__metrics"
+/* Taille d'une ligne de cache : les compteurs de deux travailleurs ne la partagent jamais */
+#define TAILLE_LIGNE_CACHE 64
+/* Nombre maximal de travailleurs dont les compteurs sont lus */
+#define MAX_TRAVAILLEURS_MESURES 1024
+/* Codes de statut comptes, de 100 a 599 */
+#define PREMIER_CODE_STATUT 100
+#define NOMBRE_CODES_STATUT 500
+/* Extensions comptees separement, la derniere case regroupe toutes les autres */
+#define NOMBRE_EXTENSIONS_MESUREES 16
+/* Intervalles de latence : exacts sous 8, puis 4 par puissance de 2, jusqu'a 2^27 (environ 134 s en us) */
+#define BITS_SOUS_INTERVALLE 2
+#define NOMBRE_INTERVALLES_LATENCE 104
+
+/**
+ * @brief Evenements du cache de descripteurs (resolutions des fichiers sous la racine)
+ */
+typedef enum {
+    DESCRIPTEUR_TROUVE,         /* resolution servie par le cache, sans appel systeme */
+    DESCRIPTEUR_RESOLU,         /* resolution faite sur le disque (openat2 puis fstat) */
+    DESCRIPTEUR_INVALIDE,       /* resolution oubliee par inotify ou a son expiration */
+    DESCRIPTEUR_EVINCE,         /* resolution oubliee pour faire place a une autre */
+    NOMBRE_EVENEMENTS_DESCRIPTEUR
+} EvenementDescripteur;
+
+/**
+ * @brief   Compteurs d'un travailleur, ecrits par lui seul \n
+ *          Note : l'alignement du premier champ aligne toute la structure, et en
+ *          arrondit la taille, sur une ligne de cache
+ */
+typedef struct {
+    _Alignas(TAILLE_LIGNE_CACHE) uint64_t requetes[NOMBRE_CODES_STATUT];   /* par code de statut */
+    uint64_t extensions[NOMBRE_EXTENSIONS_MESUREES];  /* par extension du fichier demande */
+    uint64_t latences[NOMBRE_INTERVALLES_LATENCE];
+    uint64_t sommeLatences;             /* en microsecondes */
+    uint64_t octetsEmis;
+    uint64_t connexionsOuvertes;
+    uint64_t connexionsFermees;
+    uint64_t acceptationsEchouees;
+    uint64_t refus;                     /* clients refuses en surcharge (503) */
+    uint64_t pausesAcceptation;
+    uint64_t expirations[NOMBRE_ECHEANCES];    /* connexions fermees par delai ecoule */
+    uint64_t succesCache;
+    uint64_t echecsCache;
+    uint64_t descripteurs[NOMBRE_EVENEMENTS_DESCRIPTEUR];
+    uint64_t journalPerdus;             /* enregistrements du journal perdus, anneau plein */
+} Mesures;
+
+/**
+ * @brief   Inscrit les compteurs du travailleur courant parmi ceux lus par /__metrics \n
+ *          Note : a appeler au demarrage de chaque travailleur
+ *
+ * @return  int -> Retourne 1 si ca s'est bien passe, 0 s'il y a trop de travailleurs
+ */
+int inscrireMesures(void);
+
+/**
+ * @brief Instant courant d'une horloge monotone
+ *
+ * @return uint64_t -> Retourne l'instant en microsecondes
+ */
+uint64_t instantUs(void);
+
+/**
+ * @brief   Intervalle de l'histogramme ou tombe une duree, comme HdrHistogram : les bits
+ *          qui suivent le bit de poids fort choisissent le sous-intervalle 
+
+ *          Note : l'unite est celle de la duree, les dernieres tombent toutes dans le dernier
+ *
+ * @param duree     Duree a classer
+ * @return          size_t -> Retourne l'indice de l'intervalle, inferieur a NOMBRE_INTERVALLES_LATENCE
+ */
+size_t intervalleLatence(uint64_t duree);
+
+/**
+ * @brief Premiere duree au-dela d'un intervalle de l'histogramme
+ *
+ * @param indice    Indice de l'intervalle
+ * @return          uint64_t -> Retourne la borne superieure exclue de l'intervalle
+ */
+uint64_t finIntervalle(size_t indice);
+
+/**
+ * @brief Compte une requete traitee et sa latence
+ *
+ * @param statut    Code de statut de la reponse, 0 si inconnu
+ * @param debut     Instant de debut du traitement, donne par instantUs
+ * @return          uint64_t -> Retourne la duree du traitement en microsecondes
+ */
+uint64_t mesurerRequete(int statut, uint64_t debut);
+
+/**
+ * @brief Compte une requete selon l'extension du fichier demande
+ *
+ * @param nomFichier    Chemin normalise du fichier demande
+ */
+void compterFichier(const char *nomFichier);
+
+/**
+ * @brief Compte les octets envoyes aux clients
+ *
+ * @param octets    Nombre d'octets acceptes par le noyau
+ */
+void compterOctetsEmis(size_t octets);
+
+/**
+ * @brief Compte une connexion acceptee
+ */
+void compterOuverture(void);
+
+/**
+ * @brief Compte une connexion fermee
+ */
+void compterFermeture(void);
+
+/**
+ * @brief Compte une acceptation de client qui a echoue
+ */
+void compterAcceptationEchouee(void);
+
+/**
+ * @brief Compte un client refuse en surcharge par une reponse 503
+ */
+void compterRefus(void);
+
+/**
+ * @brief Compte une suspension des acceptations, faute de descripteurs ou de memoire
+ */
+void compterPauseAcceptation(void);
+
+/**
+ * @brief Compte une connexion fermee faute d'activite dans le delai surveille
+ *
+ * @param echeance  Delai ecoule
+ */
+void compterExpiration(EcheanceConnexion echeance);
+
+/**
+ * @brief Compte une recherche dans le cache de reponses
+ *
+ * @param succes    TRUE si la reponse etait en cache
+ */
+void compterCache(bool succes);
+
+/**
+ * @brief Compte un evenement du cache de descripteurs
+ *
+ * @param evenement Evenement survenu
+ */
+void compterDescripteur(EvenementDescripteur evenement);
+
+/**
+ * @brief Compte un enregistrement du journal des acces perdu faute de place
+ */
+void compterJournalPerdu(void);
+
+/**
+ * @brief   Emet la reponse de /__metrics : somme des compteurs de tous les travailleurs \n
+ *          Note : la page est emise en flux, formatee morceau par morceau au rythme du client
+ *
+ * @param connexion Connexion du client
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerMesures(Connexion *connexion);
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file    mime.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de la table des types MIME \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "mime.h"
+
+/**
+ * @brief Association d'une extension (en minuscules) a son type MIME
+ */
+typedef struct {
+    char extension[TAILLE_MAX_EXTENSION];
+    char *type;
+} TypeMime;
+
+/* Types connus meme sans fichier mime.types */
+static const char *typesHistoriques[][2] = {
+    {"html", "text/html"},
+    {"css", "text/css"},
+    {"js", "application/javascript"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"ico", "image/x-icon"}
+};
+
+/* Variables cachees, remplies au demarrage puis en lecture seule */
+
+/* table a adressage ouvert, toujours remplie a moins de moitie */
+static TypeMime *tableMime;
+static size_t capaciteMime;
+static size_t nombreMime;
+
+/**
+ * @brief Hachage FNV-1a de l'extension, insensible a la casse
+ */
+static size_t hacherExtension(const char *extension) {
+    size_t hachage = 2166136261u;
+
+    while (*extension != '\0') {
+        hachage ^= (unsigned char) tolower((unsigned char) *extension++);
+        hachage *= 16777619u;
+    }
+
+    return hachage;
+}
+
+/**
+ * @brief Place une association dans la table, sans agrandissement
+ */
+static void placerTypeMime(TypeMime *table, size_t capacite, const char *extension, char *type) {
+    size_t position = hacherExtension(extension) & (capacite - 1);
+
+    // Sondage lineaire jusqu'a une case libre ou la meme extension
+    while ((table[position].type != NULL) && (strcmp(table[position].extension, extension) != 0)) {
+        position = (position + 1) & (capacite - 1);
+    }
+
+    // La premiere definition d'une extension l'emporte, comme dans mime.types
+    if (table[position].type == NULL) {
+        strcpy(table[position].extension, extension);
+        table[position].type = type;
+        nombreMime++;
+    }
+}
+
+/**
+ * @brief Ajoute une association, en doublant la table au-dela de la moitie de remplissage
+ */
+static int ajouterTypeMime(const char *extension, char *type) {
+    char minuscules[TAILLE_MAX_EXTENSION];
+    TypeMime *table = NULL;
+    size_t capacite, i;
+
+    if (strlen(extension) >= TAILLE_MAX_EXTENSION) {
+        fprintf(stderr, "Extension %s trop longue, ignoree\n", extension);
+        return 1;
+    }
+
+    for (i = 0; extension[i] != '\0'; i++) {
+        minuscules[i] = (char) tolower((unsigned char) extension[i]);
+    }
+    minuscules[i] = '\0';
+
+    if ((nombreMime + 1) * 2 > capaciteMime) {
+        capacite = (capaciteMime > 0) ? capaciteMime * 2 : 64;
+
+        if ((table = calloc(capacite, sizeof(TypeMime))) == NULL) {
+            fprintf(stderr, "Erreur d'allocation memoire\n");
+            return 0;
+        }
+
+        nombreMime = 0;
+        for (i = 0; i < capaciteMime; i++) {
+            if (tableMime[i].type != NULL) {
+                placerTypeMime(table, capacite, tableMime[i].extension, tableMime[i].type);
+            }
+        }
+
+        free(tableMime);
+        tableMime = table;
+        capaciteMime = capacite;
+    }
+
+    placerTypeMime(tableMime, capaciteMime, minuscules, type);
+
+    return 1;
+}
+
+/**
+ * @brief Charge les types historiques du serveur
+ */
+static void chargerTypesHistoriques(void) {
+    size_t i;
+
+    for (i = 0; i < sizeof(typesHistoriques) / sizeof(typesHistoriques[0]); i++) {
+        ajouterTypeMime(typesHistoriques[i][0], (char *) (uintptr_t) typesHistoriques[i][1]);
+    }
+}
+
+int chargerTypesMime(char *nomFichier) {
+    FILE *fichier = NULL;
+    char ligne[1024];
+    char *mot = NULL, *suite = NULL, *type = NULL;
+    size_t avant;
+
+    if ((fichier = fopen(nomFichier, "r")) == NULL) {
+        fprintf(stderr, "Fichier %s illisible, seuls les types par defaut sont connus\n", nomFichier);
+        chargerTypesHistoriques();
+        return 0;
+    }
+
+    while (fgets(ligne, sizeof(ligne), fichier) != NULL) {
+        // Les commentaires et les lignes vides sont ignores
+        if (((mot = strtok_r(ligne, " \t\r\n", &suite)) == NULL) || (mot[0] == '#')) {
+            continue;
+        }
+
+        // Le type est partage par toutes les extensions de la ligne
+        if ((type = strdup(mot)) == NULL) {
+            fprintf(stderr, "Erreur d'allocation memoire\n");
+            break;
+        }
+
+        avant = nombreMime;
+        while ((mot = strtok_r(NULL, " \t\r\n", &suite)) != NULL) {
+            if (!(ajouterTypeMime(mot, type))) {
+                break;
+            }
+        }
+
+        // Type sans extension, ou dont toutes les extensions etaient deja definies : personne ne le garde
+        if (nombreMime == avant) {
+            free(type);
+        }
+    }
+
+    fclose(fichier);
+
+    // Les types historiques completent le fichier sans en ecraser les definitions
+    chargerTypesHistoriques();
+    printf("%lu types MIME charges depuis %s.\n", (unsigned long) nombreMime, nomFichier);
+
+    return 1;
+}
+
+char *chercherTypeMime(char *extension) {
+    size_t position;
+
+    if (capaciteMime == 0) {
+        return NULL;
+    }
+
+    position = hacherExtension(extension) & (capaciteMime - 1);
+
+    // La table etant a moitie vide, le sondage s'arrete en quelques cases
+    while (tableMime[position].type != NULL) {
+        if (!(strcasecmp(tableMime[position].extension, extension))) {
+            return tableMime[position].type;
+        }
+        position = (position + 1) & (capaciteMime - 1);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file    mime.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de la table des types MIME \n
+ *          La table est chargee une fois au demarrage depuis un fichier
+ *          au format mime.types, puis consultee en lecture seule par
+ *          tous les travailleurs.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __MIME_H__
+#define __MIME_H__
+
+#include "serveur.h"
+
+/* Fichier de types charge par defaut, relatif au repertoire du serveur */
+#define FICHIER_MIME_DEFAUT "mime.types"
+/* Longueur maximale d'une extension, point exclu et zero final inclus */
+#define TAILLE_MAX_EXTENSION 16
+/* Type des fichiers sans extension ou d'extension inconnue */
+#define TYPE_MIME_DEFAUT "application/octet-stream"
+
+/**
+ * @brief   Charge la table des types MIME depuis un fichier au format mime.types \n
+ *          Note : a appeler avant le demarrage des travailleurs. Si le fichier est
+ *          illisible, seuls les types historiques du serveur sont connus
+ *
+ * @param nomFichier    Fichier de correspondance types / extensions
+ * @return              int -> Retourne 1 si le fichier a ete charge, 0 sinon
+ */
+int chargerTypesMime(char *nomFichier);
+
+/**
+ * @brief Recherche le type MIME associe a une extension, sans tenir compte de la casse
+ *
+ * @param extension Extension du fichier demande, sans le point
+ * @return          char* -> Retourne le type MIME, NULL si l'extension est inconnue
+ */
+char *chercherTypeMime(char *extension);
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * @file    minuterie.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de la roue de minuteries \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "minuterie.h"
+
+uint64_t instantMs(void) {
+    struct timespec instant;
+
+    clock_gettime(CLOCK_MONOTONIC, &instant);
+
+    return (uint64_t) instant.tv_sec * 1000 + (uint64_t) instant.tv_nsec / 1000000;
+}
+
+/* Nombre de ticks couverts par les niveaux inferieurs a un niveau donne */
+#define PORTEE_NIVEAU(niveau) ((uint64_t) 1 << (BITS_ROUE * (niveau)))
+
+void initialiserRoue(RoueMinuterie *roue, uint64_t maintenant) {
+    size_t niveau, i;
+
+    // Chaque alveole est une liste circulaire dont la sentinelle pointe sur elle-meme
+    for (niveau = 0; niveau < NIVEAUX_ROUE; niveau++) {
+        for (i = 0; i < TAILLE_ROUE; i++) {
+            roue->alveoles[niveau][i].precedent = &roue->alveoles[niveau][i];
+            roue->alveoles[niveau][i].suivant = &roue->alveoles[niveau][i];
+        }
+    }
+
+    roue->tickCourant = maintenant / RESOLUTION_ROUE_MS;
+}
+
+void initialiserMinuterie(Minuterie *minuterie) {
+    minuterie->precedent = NULL;
+    minuterie->suivant = NULL;
+    minuterie->echeance = 0;
+}
+
+/**
+ * @brief Range une minuterie dans l'alveole du niveau le plus fin qui couvre son tick
+ */
+static void placerMinuterie(RoueMinuterie *roue, Minuterie *minuterie, uint64_t tick) {
+    Minuterie *sentinelle = NULL;
+    uint64_t ecart = tick - roue->tickCourant;
+    size_t niveau = 0;
+
+    // Au-dela de la portee de la roue, la minuterie attend au dernier tick couvert
+    if (ecart >= PORTEE_NIVEAU(NIVEAUX_ROUE)) {
+        tick = roue->tickCourant + PORTEE_NIVEAU(NIVEAUX_ROUE) - 1;
+        ecart = PORTEE_NIVEAU(NIVEAUX_ROUE) - 1;
+    }
+
+    while (ecart >= PORTEE_NIVEAU(niveau + 1)) {
+        niveau++;
+    }
+
+    sentinelle = &roue->alveoles[niveau][(tick >> (BITS_ROUE * niveau)) & (TAILLE_ROUE - 1)];
+    minuterie->suivant = sentinelle;
+    minuterie->precedent = sentinelle->precedent;
+    sentinelle->precedent->suivant = minuterie;
+    sentinelle->precedent = minuterie;
+}
+
+void armerMinuterie(RoueMinuterie *roue, Minuterie *minuterie, uint64_t echeance) {
+    // Alveole du tick qui suit l'echeance : quand elle est parcourue, l'echeance est passee
+    uint64_t tick = echeance / RESOLUTION_ROUE_MS + 1;
+
+    desarmerMinuterie(minuterie);
+
+    // Une echeance deja passee est traitee au prochain tick
+    if (tick <= roue->tickCourant) {
+        tick = roue->tickCourant + 1;
+    }
+
+    minuterie->echeance = echeance;
+    placerMinuterie(roue, minuterie, tick);
+}
+
+void desarmerMinuterie(Minuterie *minuterie) {
+    if (minuterie->suivant == NULL) {
+        return;
+    }
+
+    minuterie->precedent->suivant = minuterie->suivant;
+    minuterie->suivant->precedent = minuterie->precedent;
+    minuterie->precedent = NULL;
+    minuterie->suivant = NULL;
+}
+
+/**
+ * @brief   Redistribue une alveole d'un niveau superieur dans les niveaux inferieurs \n
+ *          Note : ses minuteries echoient toutes pendant le tour qui commence
+ */
+static void cascaderAlveole(RoueMinuterie *roue, Minuterie *sentinelle) {
+    Minuterie *minuterie = NULL;
+    uint64_t tick;
+
+    while ((minuterie = sentinelle->suivant) != sentinelle) {
+        desarmerMinuterie(minuterie);
+
+        // Le tick courant n'a pas encore ete parcouru : il peut recevoir les echeances passees
+        tick = minuterie->echeance / RESOLUTION_ROUE_MS + 1;
+        if (tick < roue->tickCourant) {
+            tick = roue->tickCourant;
+        }
+
+        placerMinuterie(roue, minuterie, tick);
+    }
+}
+
+void avancerRoue(RoueMinuterie *roue, uint64_t maintenant, ExpirationMinuterie expiration) {
+    uint64_t tickCible = maintenant / RESOLUTION_ROUE_MS;
+    Minuterie *sentinelle = NULL, *minuterie = NULL;
+    size_t niveau;
+
+    while (roue->tickCourant < tickCible) {
+        roue->tickCourant++;
+
+        // A chaque tour complet d'un niveau, l'alveole suivante du niveau superieur redescend,
+        // en commencant par le plus haut niveau concerne
+        for (niveau = 1; (niveau < NIVEAUX_ROUE) &&
+             ((roue->tickCourant & (PORTEE_NIVEAU(niveau) - 1)) == 0); niveau++) {
+        }
+        while (--niveau > 0) {
+            cascaderAlveole(roue, &roue->alveoles[niveau][(roue->tickCourant >> (BITS_ROUE * niveau)) &
+                                                         (TAILLE_ROUE - 1)]);
+        }
+
+        // Toutes les minuteries de l'alveole du tick sont echues
+        sentinelle = &roue->alveoles[0][roue->tickCourant & (TAILLE_ROUE - 1)];
+
+        // L'expiration peut liberer la structure qui contient la minuterie
+        while ((minuterie = sentinelle->suivant) != sentinelle) {
+            desarmerMinuterie(minuterie);
+            expiration(minuterie);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * @file    minuterie.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de la roue de minuteries \n
+ *          Chaque travailleur range les echeances de ses connexions dans
+ *          une roue hierarchique : le premier niveau a une alveole par tick,
+ *          chaque niveau suivant couvre un tour entier du precedent par
+ *          alveole. Armer, rearmer ou desarmer une minuterie se fait en temps
+ *          constant ; une minuterie lointaine ne redescend d'un niveau qu'une
+ *          fois par tour du niveau inferieur, et seules les alveoles echues
+ *          sont parcourues a chaque tour du reacteur.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __MINUTERIE_H__
+#define __MINUTERIE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Nombre d'alveoles de chaque niveau de la roue, en puissance de 2 */
+#define BITS_ROUE 6
+#define TAILLE_ROUE (1 << BITS_ROUE)
+/* Nombre de niveaux : la roue couvre TAILLE_ROUE ^ NIVEAUX_ROUE ticks */
+#define NIVEAUX_ROUE 4
+/* Duree couverte par une alveole en millisecondes */
+#define RESOLUTION_ROUE_MS 1000
+
+/**
+ * @brief Maillon d'une minuterie, a inclure dans la structure a surveiller
+ */
+typedef struct Minuterie {
+    struct Minuterie *precedent;
+    struct Minuterie *suivant;
+    uint64_t echeance;          /* instant d'expiration en millisecondes */
+} Minuterie;
+
+/**
+ * @brief Roue de minuteries d'un travailleur
+ */
+typedef struct {
+    Minuterie alveoles[NIVEAUX_ROUE][TAILLE_ROUE];  /* sentinelles des listes circulaires */
+    uint64_t tickCourant;               /* dernier tick entierement traite */
+} RoueMinuterie;
+
+/**
+ * @brief Fonction appelee pour chaque minuterie echue, deja desarmee
+ */
+typedef void (*ExpirationMinuterie)(Minuterie *minuterie);
+
+/**
+ * @brief Instant courant de l'horloge monotone en millisecondes
+ *
+ * @return uint64_t -> Retourne le nombre de millisecondes depuis une origine arbitraire
+ */
+uint64_t instantMs(void);
+
+/**
+ * @brief Initialise une roue vide
+ *
+ * @param roue          Roue a initialiser
+ * @param maintenant    Instant courant en millisecondes
+ */
+void initialiserRoue(RoueMinuterie *roue, uint64_t maintenant);
+
+/**
+ * @brief Initialise une minuterie desarmee
+ *
+ * @param minuterie Minuterie a initialiser
+ */
+void initialiserMinuterie(Minuterie *minuterie);
+
+/**
+ * @brief   (Re)arme une minuterie pour une echeance donnee, en temps constant \n
+ *          Note : une echeance au-dela de la portee de la roue est rapprochee au
+ *          dernier tick couvert, ou elle est replacee jusqu'a etre atteinte
+ *
+ * @param roue      Roue du travailleur
+ * @param minuterie Minuterie a armer, desarmee au prealable si besoin
+ * @param echeance  Instant d'expiration en millisecondes
+ */
+void armerMinuterie(RoueMinuterie *roue, Minuterie *minuterie, uint64_t echeance);
+
+/**
+ * @brief Desarme une minuterie, sans effet si elle ne l'est pas
+ *
+ * @param minuterie Minuterie a desarmer
+ */
+void desarmerMinuterie(Minuterie *minuterie);
+
+/**
+ * @brief   Fait avancer la roue jusqu'a l'instant courant et signale les minuteries echues \n
+ *          Note : chaque tick passe coute un acces a une alveole, meme apres une longue pause
+ *
+ * @param roue          Roue du travailleur
+ * @param maintenant    Instant courant en millisecondes
+ * @param expiration    Fonction appelee pour chaque minuterie echue
+ */
+void avancerRoue(RoueMinuterie *roue, uint64_t maintenant, ExpirationMinuterie expiration);
+
+#endif
@@ -0,0 +1,226 @@
+/**
+ * @file    plage.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source des requetes partielles (Range) \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "cache.h"
+#include "plage.h"
+
+#include <time.h>
+
+/* Numero des separateurs de parties, propre a chaque travailleur */
+static _Thread_local unsigned long numeroSeparateur;
+
+/**
+ * @brief Lit un nombre decimal positif
+ *
+ * @return bool -> Retourne FALSE s'il n'y a aucun chiffre ou si le nombre est trop grand
+ */
+static bool lireNombre(const char **position, const char *fin, off_t *valeur) {
+    const char *p = *position;
+
+    *valeur = 0;
+    while ((p < fin) && (*p >= '0') && (*p <= '9')) {
+        if (*valeur > (LLONG_MAX - 9) / 10) {
+            return FALSE;
+        }
+        *valeur = *valeur * 10 + (*p - '0');
+        p++;
+    }
+
+    if (p == *position) {
+        return FALSE;
+    }
+
+    *position = p;
+
+    return TRUE;
+}
+
+/**
+ * @brief Saute les espaces et tabulations
+ */
+static void sauterEspaces(const char **position, const char *fin) {
+    while ((*position < fin) && ((**position == ' ') || (**position == '\t'))) {
+        (*position)++;
+    }
+}
+
+int analyserPlages(const Requete *requete, const Validateurs *validateurs, off_t taille, Plage *plages) {
+    const Tranche *valeur = NULL;
+    const char *p = NULL, *fin = NULL;
+    off_t premier, dernier;
+    int demandees = 0, nombre = 0, i;
+
+    if ((valeur = chercherEntete(requete, "Range")) == NULL) {
+        return PLAGES_IGNOREES;
+    }
+
+    // Seule l'unite bytes est connue, et une representation modifiee est renvoyee en entier
+    if ((valeur->longueur < 6) || (strncasecmp(valeur->debut, "bytes=", 6) != 0) ||
+        (!(plageApplicable(requete, validateurs)))) {
+        return PLAGES_IGNOREES;
+    }
+
+    p = valeur->debut + 6;
+    fin = valeur->debut + valeur->longueur;
+
+    while (p < fin) {
+        sauterEspaces(&p, fin);
+
+        // Des elements vides peuvent separer les plages
+        if ((p < fin) && (*p == ',')) {
+            p++;
+            continue;
+        }
+
+        if (++demandees > MAX_PLAGES) {
+            return PLAGES_IGNOREES;
+        }
+
+        if ((p < fin) && (*p == '-')) {
+            // -n : les n derniers octets
+            p++;
+            if (!(lireNombre(&p, fin, &dernier))) {
+                return PLAGES_IGNOREES;
+            }
+            premier = (dernier < taille) ? taille - dernier : 0;
+            dernier = taille - 1;
+        } else {
+            // a- ou a-b : b est ramene a la fin de la representation
+            if ((!(lireNombre(&p, fin, &premier))) || (p == fin) || (*p++ != '-')) {
+                return PLAGES_IGNOREES;
+            }
+            if ((p < fin) && (*p >= '0') && (*p <= '9')) {
+                if ((!(lireNombre(&p, fin, &dernier))) || (dernier < premier)) {
+                    return PLAGES_IGNOREES;
+                }
+                if (dernier >= taille) {
+                    dernier = taille - 1;
+                }
+            } else {
+                dernier = taille - 1;
+            }
+        }
+
+        sauterEspaces(&p, fin);
+        if ((p < fin) && (*p != ',')) {
+            return PLAGES_IGNOREES;
+        }
+
+        // Une plage hors de la representation est simplement ecartee
+        if ((premier < taille) && (premier <= dernier)) {
+            plages[nombre].debut = premier;
+            plages[nombre].taille = dernier - premier + 1;
+            nombre++;
+        }
+    }
+
+    if (demandees == 0) {
+        return PLAGES_IGNOREES;
+    }
+
+    if (nombre == 0) {
+        return PLAGES_INSATISFAISABLES;
+    }
+
+    // Des plages desordonnees ou qui se chevauchent feraient emettre plusieurs fois les memes octets
+    for (i = 1; i < nombre; i++) {
+        if (plages[i].debut < plages[i - 1].debut + plages[i - 1].taille) {
+            return PLAGES_IGNOREES;
+        }
+    }
+
+    return nombre;
+}
+
+/**
+ * @brief Ajoute a la sortie le contenu d'une plage, depuis l'entree du cache ou le fichier ouvert
+ */
+static int emettrePlage(Connexion *connexion, const Plage *plage, EntreeCache *entree) {
+    if (entree != NULL) {
+        return EmissionPlageCache(connexion, entree, entree->tailleEntete + (size_t) plage->debut,
+                                  (size_t) plage->taille);
+    }
+
+    return EmissionPlageFichier(connexion, plage->debut, plage->taille);
+}
+
+/**
+ * @brief Formate l'entete d'une partie d'une reponse multipart/byteranges, precedee de son separateur
+ */
+static int formaterPartie(char *destination, size_t maxDestination, const char *separateur, const char *typeContenu,
+                          const Plage *plage, off_t taille) {
+    int longueur;
+
+    longueur = snprintf(destination, maxDestination,
+                        "\r\n--%s\r\nContent-type: %s\r\nContent-Range: bytes %lld-%lld/%lld\r\n\r\n",
+                        separateur, typeContenu, (long long) plage->debut,
+                        (long long) (plage->debut + plage->taille - 1), (long long) taille);
+
+    if ((longueur < 0) || ((size_t) longueur >= maxDestination)) {
+        fprintf(stderr, "Erreur au remplissage de l'entete\n");
+        return -1;
+    }
+
+    return longueur;
+}
+
+int envoyerPlages(Connexion *connexion, const Plage *plages, int nombre, off_t taille, char *typeContenu,
+                  const char *entetes, EntreeCache *entree) {
+    char lignes[TAILLE_MAX_ENTETE], partie[TAILLE_MAX_ENTETE], separateur[40], typeMultipart[80];
+    long long longueur = 0;
+    int longueurPartie, longueurFin, i;
+
+    // Une seule plage : le corps de la reponse est la plage elle-meme
+    if (nombre == 1) {
+        if (snprintf(lignes, sizeof(lignes), "Content-Range: bytes %lld-%lld/%lld\r\n%s",
+                     (long long) plages[0].debut, (long long) (plages[0].debut + plages[0].taille - 1),
+                     (long long) taille, entetes) >= (int) sizeof(lignes)) {
+            fprintf(stderr, "Erreur au remplissage de l'entete\n");
+            return 0;
+        }
+
+        return (EmissionEntete(connexion, "206 Partial Content", typeContenu, plages[0].taille, lignes)) &&
+               (emettrePlage(connexion, &plages[0], entree));
+    }
+
+    snprintf(separateur, sizeof(separateur), "%08lx%08lx", (unsigned long) time(NULL), ++numeroSeparateur);
+    snprintf(typeMultipart, sizeof(typeMultipart), "multipart/byteranges; boundary=%s", separateur);
+    longueurFin = snprintf(partie, sizeof(partie), "\r\n--%s--\r\n", separateur);
+
+    // La longueur totale est connue d'avance : entetes des parties, plages et separateur final
+    for (i = 0; i < nombre; i++) {
+        if ((longueurPartie = formaterPartie(partie, sizeof(partie), separateur, typeContenu, &plages[i], taille)) < 0) {
+            return 0;
+        }
+        longueur += longueurPartie + (long long) plages[i].taille;
+    }
+    longueur += longueurFin;
+
+    if (!(EmissionEntete(connexion, "206 Partial Content", typeMultipart, longueur, entetes))) {
+        return 0;
+    }
+
+    // Les entetes des parties sont copies dans la sortie, les plages emises sans copie
+    for (i = 0; i < nombre; i++) {
+        longueurPartie = formaterPartie(partie, sizeof(partie), separateur, typeContenu, &plages[i], taille);
+
+        if ((EmissionBinaire(connexion, partie, longueurPartie) < 0) || (!(emettrePlage(connexion, &plages[i], entree)))) {
+            return 0;
+        }
+    }
+
+    longueurFin = snprintf(partie, sizeof(partie), "\r\n--%s--\r\n", separateur);
+
+    return EmissionBinaire(connexion, partie, longueurFin) >= 0;
+}
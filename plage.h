@@ -0,0 +1,73 @@
+/**
+ * @file    plage.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration des requetes partielles (Range) \n
+ *          Un client peut ne demander que certaines plages d'octets d'un
+ *          fichier (reprise d'un telechargement, deplacement dans une
+ *          video). Une plage est servie en 206, plusieurs en
+ *          multipart/byteranges, toujours sans copie : depuis le cache ou
+ *          par sendfile a partir de la position demandee.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __PLAGE_H__
+#define __PLAGE_H__
+
+#include "requete.h"
+#include "serveur.h"
+#include "validation.h"
+
+/* Nombre maximal de plages servies : chacune occupe deux segments de la sortie */
+#define MAX_PLAGES ((MAX_SEGMENTS_REPONSE - 1) / 2)
+
+/* Resultats d'analyse de l'en-tete Range, en plus du nombre de plages retenues */
+#define PLAGES_IGNOREES 0
+#define PLAGES_INSATISFAISABLES (-1)
+
+/**
+ * @brief Plage d'octets demandee, bornee a la taille de la representation
+ */
+typedef struct {
+    off_t debut;
+    off_t taille;
+} Plage;
+
+/* Reponse du cache dont des plages sont emises (voir cache.h) */
+struct EntreeCache;
+
+/**
+ * @brief   Analyse l'en-tete Range d'une requete \n
+ *          Note : l'en-tete est ignore (reponse complete) s'il est absent, mal forme,
+ *          s'il demande plus de MAX_PLAGES plages ou des plages qui se chevauchent
+ *          ou sont dans le desordre, ou si If-Range ne correspond pas
+ *
+ * @param requete       Requete analysee
+ * @param validateurs   Validateurs de la representation, pour If-Range
+ * @param taille        Taille de la representation en octets
+ * @param plages        Destination des plages, MAX_PLAGES au plus
+ * @return              int -> Retourne le nombre de plages retenues, PLAGES_IGNOREES ou
+ *                      PLAGES_INSATISFAISABLES si aucune plage n'est dans la representation
+ */
+int analyserPlages(const Requete *requete, const Validateurs *validateurs, off_t taille, Plage *plages);
+
+/**
+ * @brief   Ajoute a la sortie du client une reponse 206 contenant les plages demandees \n
+ *          Note : sans entree de cache, le corps est pris dans le fichier ouvert par
+ *          ouvrirFichierSortie
+ *
+ * @param connexion     Connexion du client
+ * @param plages        Plages retenues par analyserPlages
+ * @param nombre        Nombre de plages
+ * @param taille        Taille de la representation en octets
+ * @param typeContenu   Type MIME de la representation
+ * @param entetes       Lignes d'entete supplementaires terminees par \r\n, "" si aucune
+ * @param entree        Reponse du cache dont le contenu est decoupe, NULL pour le fichier ouvert
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerPlages(Connexion *connexion, const Plage *plages, int nombre, off_t taille, char *typeContenu,
+                  const char *entetes, struct EntreeCache *entree);
+
+#endif
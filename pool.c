@@ -0,0 +1,67 @@
+/**
+ * @file    pool.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source des reserves de blocs de taille fixe \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Alloue une dalle et chaine tous ses blocs dans la liste des disponibles
+ */
+static int ajouterDalle(Pool *pool) {
+    // Chaque bloc doit pouvoir contenir le chainage et rester aligne
+    size_t taille = (pool->tailleBloc + ALIGNEMENT_BLOC - 1) & ~((size_t) ALIGNEMENT_BLOC - 1);
+    char *dalle = NULL;
+    size_t i;
+
+    if (taille < sizeof(void *)) {
+        taille = ALIGNEMENT_BLOC;
+    }
+
+    if ((dalle = aligned_alloc(ALIGNEMENT_BLOC, taille * pool->blocsParDalle)) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 0;
+    }
+
+    // Les dalles ne sont jamais rendues : elles servent au prochain pic de connexions
+    for (i = pool->blocsParDalle; i > 0; i--) {
+        libererBloc(pool, &dalle[(i - 1) * taille]);
+    }
+    pool->dalles++;
+
+    return 1;
+}
+
+void *allouerBloc(Pool *pool) {
+    void *bloc = NULL;
+
+    if ((pool->libres == NULL) && (!(ajouterDalle(pool)))) {
+        return NULL;
+    }
+
+    bloc = pool->libres;
+    pool->libres = *(void **) bloc;
+
+    return bloc;
+}
+
+void libererBloc(Pool *pool, void *bloc) {
+    if (bloc == NULL) {
+        return;
+    }
+
+    *(void **) bloc = pool->libres;
+    pool->libres = bloc;
+}
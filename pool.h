@@ -0,0 +1,53 @@
+/**
+ * @file    pool.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration des reserves de blocs de taille fixe \n
+ *          Les connexions et leurs tampons sont pris dans des dalles de
+ *          blocs identiques et y retournent a la fermeture : une fois le
+ *          regime etabli, aucune requete ne provoque d'appel a malloc et
+ *          la memoire occupee ne depasse pas le pic de connexions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+
+/* Alignement des blocs, une ligne de cache pour que deux blocs ne se la partagent pas */
+#define ALIGNEMENT_BLOC 64
+
+/**
+ * @brief   Reserve de blocs d'une taille donnee \n
+ *          Note : une reserve n'est pas protegee, chaque travailleur a les siennes
+ */
+typedef struct {
+    void *libres;           /* liste des blocs disponibles, chaines par leur debut */
+    size_t tailleBloc;
+    size_t blocsParDalle;
+    size_t dalles;          /* nombre de dalles allouees depuis le demarrage */
+} Pool;
+
+/* Initialisation statique d'une reserve vide */
+#define POOL_INITIALISEUR(tailleBloc, blocsParDalle) { NULL, (tailleBloc), (blocsParDalle), 0 }
+
+/**
+ * @brief Prend un bloc dans la reserve, en allouant une nouvelle dalle si elle est vide
+ *
+ * @param pool  Reserve de blocs
+ * @return      void* -> Retourne un bloc aligne sur ALIGNEMENT_BLOC, NULL si la memoire manque
+ */
+void *allouerBloc(Pool *pool);
+
+/**
+ * @brief Rend un bloc a la reserve dont il provient
+ *
+ * @param pool  Reserve de blocs
+ * @param bloc  Bloc obtenu par allouerBloc sur la meme reserve, NULL accepte
+ */
+void libererBloc(Pool *pool, void *bloc);
+
+#endif
@@ -0,0 +1,227 @@
+/**
+ * @file    projection.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de la table des fichiers projetes en memoire \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "projection.h"
+#include "racine.h"
+
+#include <sys/mman.h>
+
+/* Budget commun a tous les travailleurs, fixe au demarrage (0 : mode inactif) */
+static size_t budgetProjections;
+
+/* Variables cachees, propres a chaque travailleur : aucun verrou n'est necessaire */
+
+/* table de hachage des projections par chemin */
+static _Thread_local Projection *tableProjections[TAILLE_TABLE_PROJECTIONS];
+/* liste des projections de la plus recemment utilisee a la plus ancienne */
+static _Thread_local Projection *teteLru;
+static _Thread_local Projection *queueLru;
+/* nombre d'octets projetes par les projections presentes */
+static _Thread_local size_t octetsProjetes;
+
+void configurerProjections(size_t budgetOctets) {
+    budgetProjections = budgetOctets;
+}
+
+/**
+ * @brief Hachage FNV-1a du chemin
+ */
+static size_t hacherChemin(const char *chemin) {
+    size_t hachage = 2166136261u;
+
+    while (*chemin != '\0') {
+        hachage ^= (unsigned char) *chemin++;
+        hachage *= 16777619u;
+    }
+
+    return hachage & (TAILLE_TABLE_PROJECTIONS - 1);
+}
+
+/**
+ * @brief Detruit la projection et libere sa description
+ */
+static void detruireProjection(Projection *projection) {
+    munmap(projection->adresse, projection->taille);
+    free(projection->chemin);
+    free(projection);
+}
+
+/**
+ * @brief Detache une projection de la liste LRU
+ */
+static void detacherLru(Projection *projection) {
+    if (projection->precedentLru != NULL) {
+        projection->precedentLru->suivantLru = projection->suivantLru;
+    } else {
+        teteLru = projection->suivantLru;
+    }
+
+    if (projection->suivantLru != NULL) {
+        projection->suivantLru->precedentLru = projection->precedentLru;
+    } else {
+        queueLru = projection->precedentLru;
+    }
+
+    projection->precedentLru = NULL;
+    projection->suivantLru = NULL;
+}
+
+/**
+ * @brief Place une projection en tete de la liste LRU
+ */
+static void placerEnTete(Projection *projection) {
+    projection->suivantLru = teteLru;
+
+    if (teteLru != NULL) {
+        teteLru->precedentLru = projection;
+    }
+
+    teteLru = projection;
+
+    if (queueLru == NULL) {
+        queueLru = projection;
+    }
+}
+
+/**
+ * @brief Retire une projection de la table, elle n'est detruite qu'une fois plus aucune connexion ne l'emet
+ */
+static void retirerProjection(Projection *projection) {
+    Projection **courant = &tableProjections[hacherChemin(projection->chemin)];
+
+    while (*courant != projection) {
+        courant = &(*courant)->suivantHachage;
+    }
+    *courant = projection->suivantHachage;
+
+    detacherLru(projection);
+    octetsProjetes -= projection->taille;
+    projection->retiree = TRUE;
+
+    if (projection->references == 0) {
+        detruireProjection(projection);
+    }
+}
+
+/**
+ * @brief Indique si le fichier sur le disque est toujours celui qui a ete projete
+ */
+static bool estAJour(const Projection *projection, const struct stat *infos) {
+    return (infos->st_dev == projection->peripherique) && (infos->st_ino == projection->inode) &&
+           ((size_t) infos->st_size == projection->taille) &&
+           (infos->st_mtim.tv_sec == projection->modification.tv_sec) &&
+           (infos->st_mtim.tv_nsec == projection->modification.tv_nsec);
+}
+
+/**
+ * @brief Projette un fichier resolu et l'ajoute a la table
+ */
+static Projection *projeterFichier(const char *chemin, int fichier, const struct stat *infos) {
+    Projection *projection = NULL;
+    size_t taille = (size_t) infos->st_size;
+    void *adresse = NULL;
+    size_t alveole;
+
+    if ((adresse = mmap(NULL, taille, PROT_READ, MAP_SHARED, fichier, 0)) == MAP_FAILED) {
+        perror("projeterFichier, erreur de mmap.");
+        return NULL;
+    }
+
+    // Un telechargement lit le fichier du debut a la fin : lecture anticipee large, pages liberees apres usage
+    madvise(adresse, taille, MADV_SEQUENTIAL);
+
+    if (((projection = calloc(1, sizeof(Projection))) == NULL) || ((projection->chemin = strdup(chemin)) == NULL)) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        free(projection);
+        munmap(adresse, taille);
+        return NULL;
+    }
+
+    projection->adresse = adresse;
+    projection->taille = taille;
+    projection->peripherique = infos->st_dev;
+    projection->inode = infos->st_ino;
+    projection->modification = infos->st_mtim;
+
+    // On retire les projections les moins recemment utilisees jusqu'a faire de la place
+    while ((octetsProjetes + taille > budgetProjections) && (queueLru != NULL)) {
+        retirerProjection(queueLru);
+    }
+
+    alveole = hacherChemin(chemin);
+    projection->suivantHachage = tableProjections[alveole];
+    tableProjections[alveole] = projection;
+    placerEnTete(projection);
+    octetsProjetes += taille;
+
+    return projection;
+}
+
+Projection *prendreProjection(const char *chemin) {
+    Projection *projection = NULL;
+    struct stat infos;
+    int fichier;
+
+    if (budgetProjections == 0) {
+        return NULL;
+    }
+
+    // L'etat du fichier vient du cache de resolutions : la verification ne coute aucun appel systeme
+    if ((fichier = resoudreFichier(chemin, &infos)) < 0) {
+        return NULL;
+    }
+
+    projection = tableProjections[hacherChemin(chemin)];
+    while ((projection != NULL) && (strcmp(projection->chemin, chemin) != 0)) {
+        projection = projection->suivantHachage;
+    }
+
+    // Un fichier modifie est projete a nouveau, l'ancienne projection finit les envois en cours
+    if ((projection != NULL) && (!(estAJour(projection, &infos)))) {
+        retirerProjection(projection);
+        projection = NULL;
+    }
+
+    if (projection == NULL) {
+        // mmap refuse un fichier vide, et un tres gros fichier occuperait tout le budget
+        if ((infos.st_size == 0) || ((size_t) infos.st_size > TAILLE_MAX_PROJECTION) ||
+            ((size_t) infos.st_size > budgetProjections) ||
+            ((projection = projeterFichier(chemin, fichier, &infos)) == NULL)) {
+            return NULL;
+        }
+    } else {
+        detacherLru(projection);
+        placerEnTete(projection);
+    }
+
+    projection->references++;
+
+    return projection;
+}
+
+void relacherProjection(Projection *projection) {
+    projection->references--;
+
+    if ((projection->references == 0) && (projection->retiree)) {
+        detruireProjection(projection);
+    }
+}
+
+void annoncerLecture(Projection *projection, off_t debut, off_t taille) {
+    long page = sysconf(_SC_PAGESIZE);
+    off_t alignement = debut % page;
+
+    // madvise veut une adresse alignee sur une page
+    madvise(projection->adresse + debut - alignement, (size_t) (taille + alignement), MADV_WILLNEED);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file    projection.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de la table des fichiers projetes en memoire \n
+ *          Dans ce mode d'envoi, le corps des fichiers trop gros pour le cache
+ *          de reponses est emis depuis une projection (mmap) plutot que par
+ *          sendfile. Chaque fichier est projete une seule fois par travailleur
+ *          et partage par toutes les reponses en cours : N telechargements
+ *          simultanes du meme fichier n'occupent qu'une projection. Elle est
+ *          retiree quand le fichier change ou pour faire de la place, et
+ *          detruite une fois la derniere reponse emise.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __PROJECTION_H__
+#define __PROJECTION_H__
+
+#include "serveur.h"
+
+#include <time.h>
+
+/* Nombre d'alveoles de la table de hachage (puissance de 2) */
+#define TAILLE_TABLE_PROJECTIONS 256
+/* Espace d'adressage projete par defaut par chaque travailleur en octets */
+#define BUDGET_PROJECTIONS_DEFAUT (256 * 1024 * 1024)
+/* Taille maximale d'un fichier projete, au-dela il est toujours emis par sendfile */
+#define TAILLE_MAX_PROJECTION (64 * 1024 * 1024)
+
+/**
+ * @brief Fichier projete en memoire, partage par les reponses qui l'emettent
+ */
+typedef struct Projection {
+    char *chemin;
+    char *adresse;              /* debut de la projection, en lecture seule */
+    size_t taille;
+    dev_t peripherique;         /* identite du fichier lors de la projection */
+    ino_t inode;
+    struct timespec modification;
+    int references;             /* connexions en cours d'emission de ce fichier */
+    bool retiree;               /* retiree de la table, detruite quand plus referencee */
+    struct Projection *suivantHachage;
+    struct Projection *precedentLru;
+    struct Projection *suivantLru;
+} Projection;
+
+/**
+ * @brief   Active l'envoi des fichiers par projection et fixe l'espace projete par travailleur \n
+ *          Note : a appeler avant le demarrage des travailleurs
+ *
+ * @param budgetOctets  Nombre d'octets projetes au plus, 0 pour toujours utiliser sendfile
+ */
+void configurerProjections(size_t budgetOctets);
+
+/**
+ * @brief   Renvoie la projection d'un fichier, creee si besoin, et la reference \n
+ *          Note : penser a la rendre avec relacherProjection
+ *
+ * @param chemin    Chemin normalise, relatif a la racine
+ * @return          Projection* -> Retourne la projection a jour, NULL si le mode est
+ *                  inactif ou si le fichier ne s'y prete pas (vide, trop gros, erreur)
+ */
+Projection *prendreProjection(const char *chemin);
+
+/**
+ * @brief Rend une projection prise par prendreProjection, et la detruit si elle a ete retiree
+ *
+ * @param projection    Projection a relacher
+ */
+void relacherProjection(Projection *projection);
+
+/**
+ * @brief   Previent le noyau qu'une plage de la projection va etre lue \n
+ *          Note : la lecture anticipee est lancee sans attendre
+ *
+ * @param projection    Projection du fichier
+ * @param debut         Position du premier octet
+ * @param taille        Nombre d'octets
+ */
+void annoncerLecture(Projection *projection, off_t debut, off_t taille);
+
+#endif
@@ -0,0 +1,443 @@
+/**
+ * @file    racine.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de la racine des documents et du cache de descripteurs \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "racine.h"
+#include "mesures.h"
+
+#include <linux/openat2.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <time.h>
+
+/* Evenements d'un repertoire qui rendent perimees les resolutions de ses fichiers */
+#define EVENEMENTS_SURVEILLES (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | \
+                               IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+/* Nombre de repertoires surveilles a la fois : au plus un par resolution gardee, plus celle en cours */
+#define NOMBRE_SURVEILLANCES (NOMBRE_DESCRIPTEURS + 1)
+/* Nombre d'alveoles de la table des surveillances, indexee par numero de surveillance (puissance de 2) */
+#define TAILLE_TABLE_SURVEILLANCES 256
+
+/**
+ * @brief   Repertoire surveille par inotify \n
+ *          Note : la surveillance est retiree quand plus aucune resolution gardee n'en depend
+ */
+typedef struct Surveillance {
+    int numero;                 /* numero rendu par inotify_add_watch */
+    char repertoire[LONGUEUR_MAX_CHEMIN];   /* relatif a la racine, "" pour la racine */
+    size_t references;          /* resolutions gardees dans ce repertoire */
+    struct Surveillance *suivant;   /* dans son alveole, ou parmi les surveillances libres */
+} Surveillance;
+
+/**
+ * @brief Resolution d'un chemin gardee par le travailleur
+ */
+typedef struct Descripteur {
+    char chemin[LONGUEUR_MAX_CHEMIN];
+    int fd;                     /* -1 si le fichier est absent ou inaccessible */
+    int erreur;                 /* errno de l'echec de resolution */
+    struct stat infos;
+    Surveillance *surveillance; /* surveillance du repertoire parent, NULL si aucune */
+    time_t resolution;
+    struct Descripteur *suivantHachage;
+    struct Descripteur *precedentLru;
+    struct Descripteur *suivantLru;
+} Descripteur;
+
+/* Racine commune a tous les travailleurs, ouverte au demarrage puis en lecture seule */
+static int racine = -1;
+static char racineAbsolue[PATH_MAX];
+
+/* Cache du travailleur */
+static _Thread_local Descripteur *descripteurs;
+static _Thread_local size_t nombreDescripteurs;
+static _Thread_local Descripteur *tableDescripteurs[TAILLE_TABLE_DESCRIPTEURS];
+static _Thread_local Descripteur *teteLru;
+static _Thread_local Descripteur *queueLru;
+
+/* Notifications du travailleur et ses repertoires surveilles */
+static _Thread_local int notifications = -1;
+static _Thread_local Surveillance *surveillances;
+static _Thread_local Surveillance *surveillancesLibres;
+static _Thread_local Surveillance *tableSurveillances[TAILLE_TABLE_SURVEILLANCES];
+
+/**
+ * @brief Ouvre un fichier sous la racine, sans jamais en sortir
+ */
+static int ouvrirSousRacine(const char *chemin) {
+    struct open_how comment;
+
+    memset(&comment, 0, sizeof(comment));
+    comment.flags = O_RDONLY | O_CLOEXEC;
+    comment.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+
+    return (int) syscall(SYS_openat2, racine, chemin, &comment, sizeof(comment));
+}
+
+int configurerRacine(char *chemin) {
+    int fd;
+
+    // O_PATH suffit : la racine ne sert que de point de depart aux resolutions
+    if ((racine = open(chemin, O_PATH | O_DIRECTORY | O_CLOEXEC)) < 0) {
+        fprintf(stderr, "Impossible d'ouvrir la racine %s : %s\n", chemin, strerror(errno));
+        return 0;
+    }
+
+    // Sans openat2 (noyau anterieur a 5.6, filtre seccomp), un lien pourrait sortir de la racine : on refuse de demarrer
+    if ((fd = ouvrirSousRacine(".")) < 0) {
+        fprintf(stderr, "Impossible de confiner les resolutions sous la racine %s : %s\n", chemin, strerror(errno));
+        return 0;
+    }
+    close(fd);
+
+    // inotify ne connait que des chemins : on garde celui de la racine
+    if (realpath(chemin, racineAbsolue) == NULL) {
+        perror("configurerRacine, erreur de realpath.");
+        return 0;
+    }
+
+    printf("Racine des documents : %s.\n", racineAbsolue);
+
+    return 1;
+}
+
+int initialiserDescripteurs(void) {
+    size_t i;
+
+    if (((descripteurs = calloc(NOMBRE_DESCRIPTEURS, sizeof(Descripteur))) == NULL) ||
+        ((surveillances = calloc(NOMBRE_SURVEILLANCES, sizeof(Surveillance))) == NULL)) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 0;
+    }
+
+    for (i = 0; i < NOMBRE_SURVEILLANCES; i++) {
+        surveillances[i].suivant = surveillancesLibres;
+        surveillancesLibres = &surveillances[i];
+    }
+
+    if ((notifications = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0) {
+        perror("initialiserDescripteurs, erreur de inotify_init1.");
+    }
+
+    return 1;
+}
+
+int notificationsRacine(void) {
+    return notifications;
+}
+
+/**
+ * @brief Fonction de hachage FNV-1a d'un chemin
+ */
+static size_t hacherChemin(const char *chemin) {
+    size_t hache = 2166136261u;
+
+    while (*chemin != '\0') {
+        hache = (hache ^ (unsigned char) *chemin++) * 16777619u;
+    }
+
+    return hache & (TAILLE_TABLE_DESCRIPTEURS - 1);
+}
+
+/**
+ * @brief Retire une entree de la liste LRU
+ */
+static void detacherLru(Descripteur *descripteur) {
+    if (descripteur->precedentLru != NULL) {
+        descripteur->precedentLru->suivantLru = descripteur->suivantLru;
+    } else {
+        teteLru = descripteur->suivantLru;
+    }
+
+    if (descripteur->suivantLru != NULL) {
+        descripteur->suivantLru->precedentLru = descripteur->precedentLru;
+    } else {
+        queueLru = descripteur->precedentLru;
+    }
+
+    descripteur->precedentLru = NULL;
+    descripteur->suivantLru = NULL;
+}
+
+/**
+ * @brief Place une entree en tete de la liste LRU
+ */
+static void placerEnTete(Descripteur *descripteur) {
+    descripteur->suivantLru = teteLru;
+
+    if (teteLru != NULL) {
+        teteLru->precedentLru = descripteur;
+    }
+
+    teteLru = descripteur;
+
+    if (queueLru == NULL) {
+        queueLru = descripteur;
+    }
+}
+
+/**
+ * @brief Recherche une surveillance par son numero, NULL si le repertoire n'est plus surveille
+ */
+static Surveillance *chercherSurveillance(int numero) {
+    Surveillance *surveillance = tableSurveillances[(unsigned) numero & (TAILLE_TABLE_SURVEILLANCES - 1)];
+
+    while ((surveillance != NULL) && (surveillance->numero != numero)) {
+        surveillance = surveillance->suivant;
+    }
+
+    return surveillance;
+}
+
+/**
+ * @brief Rend une reference sur une surveillance, retiree du noyau avec la derniere
+ */
+static void relacherSurveillance(Surveillance *surveillance) {
+    Surveillance **courant = NULL;
+
+    if ((surveillance == NULL) || (--surveillance->references > 0)) {
+        return;
+    }
+
+    courant = &tableSurveillances[(unsigned) surveillance->numero & (TAILLE_TABLE_SURVEILLANCES - 1)];
+    while (*courant != surveillance) {
+        courant = &(*courant)->suivant;
+    }
+    *courant = surveillance->suivant;
+
+    // Le noyau confirmera par IN_IGNORED, ignore puisque le numero n'est plus dans la table
+    inotify_rm_watch(notifications, surveillance->numero);
+
+    surveillance->suivant = surveillancesLibres;
+    surveillancesLibres = surveillance;
+}
+
+/**
+ * @brief Oublie une resolution : l'entree est retiree de la table et son descripteur ferme
+ */
+static void oublierDescripteur(Descripteur *descripteur) {
+    Descripteur **courant = &tableDescripteurs[hacherChemin(descripteur->chemin)];
+
+    while (*courant != descripteur) {
+        courant = &(*courant)->suivantHachage;
+    }
+    *courant = descripteur->suivantHachage;
+
+    detacherLru(descripteur);
+
+    if (descripteur->fd >= 0) {
+        close(descripteur->fd);
+    }
+    descripteur->fd = -1;
+    descripteur->chemin[0] = '\0';
+
+    relacherSurveillance(descripteur->surveillance);
+    descripteur->surveillance = NULL;
+}
+
+/**
+ * @brief Oublie toutes les resolutions, quand les notifications ne permettent plus de savoir lesquelles sont perimees
+ */
+static void oublierDescripteurs(void) {
+    while (queueLru != NULL) {
+        oublierDescripteur(queueLru);
+        compterDescripteur(DESCRIPTEUR_INVALIDE);
+    }
+}
+
+/**
+ * @brief Recherche la resolution d'un chemin
+ */
+static Descripteur *chercherDescripteur(const char *chemin) {
+    Descripteur *descripteur = tableDescripteurs[hacherChemin(chemin)];
+
+    while ((descripteur != NULL) && (strcmp(descripteur->chemin, chemin) != 0)) {
+        descripteur = descripteur->suivantHachage;
+    }
+
+    return descripteur;
+}
+
+/**
+ * @brief Surveille le repertoire qui contient un chemin et y prend une reference
+ *
+ * @return Surveillance* -> Retourne la surveillance, NULL si le repertoire ne peut pas etre surveille
+ */
+static Surveillance *surveillerRepertoire(const char *chemin) {
+    char absolu[PATH_MAX + LONGUEUR_MAX_CHEMIN];
+    const char *separateur = strrchr(chemin, '/');
+    int longueurRepertoire = (separateur != NULL) ? (int) (separateur - chemin) : 0;
+    Surveillance *surveillance = NULL;
+    int numero;
+
+    if (notifications < 0) {
+        return NULL;
+    }
+
+    snprintf(absolu, sizeof(absolu), "%s/%.*s", racineAbsolue, longueurRepertoire, chemin);
+
+    // Un repertoire deja surveille garde son numero : l'appel est sans effet
+    if ((numero = inotify_add_watch(notifications, absolu, EVENEMENTS_SURVEILLES)) < 0) {
+        return NULL;
+    }
+
+    if ((surveillance = chercherSurveillance(numero)) == NULL) {
+        // Il y a toujours une surveillance libre : chaque resolution gardee en tient au plus une
+        surveillance = surveillancesLibres;
+        surveillancesLibres = surveillance->suivant;
+
+        surveillance->numero = numero;
+        memcpy(surveillance->repertoire, chemin, (size_t) longueurRepertoire);
+        surveillance->repertoire[longueurRepertoire] = '\0';
+        surveillance->references = 0;
+        surveillance->suivant = tableSurveillances[(unsigned) numero & (TAILLE_TABLE_SURVEILLANCES - 1)];
+        tableSurveillances[(unsigned) numero & (TAILLE_TABLE_SURVEILLANCES - 1)] = surveillance;
+    }
+
+    surveillance->references++;
+
+    return surveillance;
+}
+
+void traiterNotifications(void) {
+    char tampon[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    char chemin[LONGUEUR_MAX_CHEMIN];
+    const struct inotify_event *evenement = NULL;
+    const Surveillance *surveillance = NULL;
+    Descripteur *descripteur = NULL;
+    ssize_t lu;
+    size_t position;
+
+    // Le descripteur est non bloquant : on lit jusqu'a ce qu'il soit vide
+    while ((lu = read(notifications, tampon, sizeof(tampon))) > 0) {
+        for (position = 0; position < (size_t) lu; position += sizeof(struct inotify_event) + evenement->len) {
+            evenement = (const struct inotify_event *) (const void *) &tampon[position];
+
+            // Des evenements perdus : on ne sait plus ce qui a change
+            if (evenement->mask & IN_Q_OVERFLOW) {
+                oublierDescripteurs();
+                continue;
+            }
+
+            // Evenement d'une surveillance deja retiree
+            if ((surveillance = chercherSurveillance(evenement->wd)) == NULL) {
+                continue;
+            }
+
+            // Un repertoire deplace ou supprime : ses fichiers et sous-repertoires ont change de chemin
+            if (evenement->mask & (IN_ISDIR | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                oublierDescripteurs();
+                continue;
+            }
+
+            if (evenement->len == 0) {
+                continue;
+            }
+
+            // Un chemin trop long pour le cache ne peut pas y figurer
+            if (snprintf(chemin, sizeof(chemin), "%s%s%s", surveillance->repertoire,
+                         (surveillance->repertoire[0] != '\0') ? "/" : "", evenement->name) >= (int) sizeof(chemin)) {
+                continue;
+            }
+
+            if ((descripteur = chercherDescripteur(chemin)) != NULL) {
+                oublierDescripteur(descripteur);
+                compterDescripteur(DESCRIPTEUR_INVALIDE);
+            }
+        }
+    }
+}
+
+int resoudreFichier(const char *chemin, struct stat *infos) {
+    Descripteur *descripteur = NULL;
+    Surveillance *surveillance = NULL;
+    int fd, erreur = 0;
+
+    if ((descripteur = chercherDescripteur(chemin)) != NULL) {
+        // Un fichier dont le repertoire n'est pas surveille est resolu a nouveau de temps en temps
+        if ((descripteur->surveillance == NULL) && (time(NULL) - descripteur->resolution >= DELAI_VALIDITE_DESCRIPTEUR)) {
+            oublierDescripteur(descripteur);
+            compterDescripteur(DESCRIPTEUR_INVALIDE);
+        } else {
+            detacherLru(descripteur);
+            placerEnTete(descripteur);
+            compterDescripteur(DESCRIPTEUR_TROUVE);
+
+            if (descripteur->fd < 0) {
+                errno = descripteur->erreur;
+                return -1;
+            }
+
+            *infos = descripteur->infos;
+            return descripteur->fd;
+        }
+    }
+
+    if (strlen(chemin) >= LONGUEUR_MAX_CHEMIN) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    compterDescripteur(DESCRIPTEUR_RESOLU);
+
+    // La surveillance precede l'ouverture : une modification entre les deux ne peut pas etre manquee
+    surveillance = surveillerRepertoire(chemin);
+
+    if ((fd = ouvrirSousRacine(chemin)) >= 0) {
+        if (fstat(fd, infos) < 0) {
+            erreur = errno;
+            close(fd);
+            fd = -1;
+        } else if (!(S_ISREG(infos->st_mode))) {
+            // Seuls les fichiers reguliers sont servis
+            erreur = EISDIR;
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        erreur = errno;
+    }
+
+    // Manque de descripteurs ou de memoire : l'echec est passager, il n'est pas garde
+    if ((fd < 0) && ((erreur == EMFILE) || (erreur == ENFILE) || (erreur == ENOMEM) || (erreur == EAGAIN))) {
+        relacherSurveillance(surveillance);
+        errno = erreur;
+        return -1;
+    }
+
+    // Une entree libre, sinon celle utilisee le moins recemment
+    if (nombreDescripteurs < NOMBRE_DESCRIPTEURS) {
+        descripteur = &descripteurs[nombreDescripteurs++];
+    } else {
+        descripteur = queueLru;
+        oublierDescripteur(descripteur);
+        compterDescripteur(DESCRIPTEUR_EVINCE);
+    }
+
+    memcpy(descripteur->chemin, chemin, strlen(chemin) + 1);
+    descripteur->fd = fd;
+    descripteur->erreur = erreur;
+    if (fd >= 0) {
+        descripteur->infos = *infos;
+    }
+    descripteur->surveillance = surveillance;
+    descripteur->resolution = time(NULL);
+
+    descripteur->suivantHachage = tableDescripteurs[hacherChemin(chemin)];
+    tableDescripteurs[hacherChemin(chemin)] = descripteur;
+    placerEnTete(descripteur);
+
+    errno = erreur;
+
+    return fd;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file    racine.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de la racine des documents et du cache
+ *          de descripteurs \n
+ *          La racine est ouverte une fois au demarrage et tous les fichiers
+ *          sont resolus a partir d'elle par openat2 (RESOLVE_BENEATH) : un
+ *          chemin ne peut pas en sortir, meme par un lien symbolique. Chaque
+ *          travailleur garde les descripteurs ouverts et l'etat (stat) des
+ *          fichiers resolus, absents compris ; inotify les invalide des que le
+ *          repertoire qui les contient change. Succes, resolutions, invalidations
+ *          et evictions sont comptes dans /__metrics.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __RACINE_H__
+#define __RACINE_H__
+
+#include "serveur.h"
+
+/* Racine par defaut : le repertoire courant */
+#define RACINE_DEFAUT "."
+/* Nombre de fichiers resolus gardes par chaque travailleur */
+#define NOMBRE_DESCRIPTEURS 256
+/* Nombre d'alveoles de la table de hachage (puissance de 2) */
+#define TAILLE_TABLE_DESCRIPTEURS 512
+/* Longueur maximale d'un chemin garde en cache, terminaison comprise */
+#define LONGUEUR_MAX_CHEMIN 264
+/* Duree de validite en secondes d'une resolution quand son repertoire n'est pas surveille */
+#define DELAI_VALIDITE_DESCRIPTEUR 1
+
+/**
+ * @brief   Ouvre la racine des documents \n
+ *          Note : a appeler avant le demarrage des travailleurs ; echoue si
+ *          openat2 n'est pas disponible pour confiner les resolutions
+ *
+ * @param chemin    Repertoire servi
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int configurerRacine(char *chemin);
+
+/**
+ * @brief   Cree le cache de descripteurs du travailleur et sa file de notifications \n
+ *          Note : a appeler au demarrage de chaque travailleur ; sans inotify, les
+ *          resolutions expirent apres DELAI_VALIDITE_DESCRIPTEUR secondes
+ *
+ * @return  int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int initialiserDescripteurs(void);
+
+/**
+ * @brief Descripteur inotify du travailleur, a surveiller par le reacteur
+ *
+ * @return int -> Retourne le descripteur, -1 si inotify n'est pas disponible
+ */
+int notificationsRacine(void);
+
+/**
+ * @brief   Lit les notifications en attente et oublie les resolutions perimees \n
+ *          Note : a appeler quand notificationsRacine est lisible
+ */
+void traiterNotifications(void);
+
+/**
+ * @brief   Resout un chemin sous la racine, depuis le cache si possible \n
+ *          Note : le descripteur appartient au cache, il ne doit pas etre ferme ; il
+ *          reste valide jusqu'a la prochaine resolution ou notification
+ *
+ * @param chemin    Chemin normalise, relatif a la racine
+ * @param infos     Destination de l'etat du fichier
+ * @return          int -> Retourne un descripteur en lecture du fichier regulier, -1 s'il
+ *                  est absent ou inaccessible (errno indique la raison)
+ */
+int resoudreFichier(const char *chemin, struct stat *infos);
+
+#endif
@@ -0,0 +1,808 @@
+/**
+ * @file    reacteur.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de la boucle evenementielle du serveur \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "erreurs.h"
+#include "journal.h"
+#include "mesures.h"
+#include "racine.h"
+#include "reacteur.h"
+#include "trace.h"
+
+#include <linux/sockios.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+/**
+ * @brief Parametres transmis a chaque thread travailleur
+ */
+typedef struct {
+    char *service;
+    TraitementRequete traitement;
+} ParametresTravailleur;
+
+/* Delais des connexions en millisecondes, fixes au demarrage puis en lecture seule */
+static uint64_t delais[NOMBRE_ECHEANCES] = {
+    [ECHEANCE_ENTETES] = DELAI_ENTETES_DEFAUT * 1000,
+    [ECHEANCE_INACTIVITE] = DELAI_INACTIVITE_DEFAUT * 1000,
+    [ECHEANCE_EMISSION] = DELAI_EMISSION_DEFAUT * 1000
+};
+
+/* Mecanisme d'attente, fixe au demarrage puis en lecture seule */
+static MoteurReacteur moteur = MOTEUR_EPOLL;
+
+/* Echeances des connexions du travailleur */
+static _Thread_local RoueMinuterie roue;
+
+/* Anneau io_uring du travailleur, NULL s'il utilise epoll */
+static _Thread_local Anneau *anneauCourant;
+
+/* Repere des notifications de la racine parmi les evenements epoll */
+static _Thread_local char repereNotifications;
+
+/* Instant de reprise des acceptations suspendues, 0 si elles ne le sont pas */
+static _Thread_local uint64_t repriseAcceptation;
+
+/* Nature d'une operation io_uring, dans les bits faibles de user_data (les connexions sont alignees) */
+#define OPERATION_ACCEPTATION 0
+#define OPERATION_RECEPTION 1
+#define OPERATION_EMISSION 2
+#define OPERATION_ANNULATION 3
+#define OPERATION_NOTIFICATION 4
+#define MASQUE_OPERATION 7
+
+void configurerReacteur(int delaiInactivite, int delaiEntetes, int delaiEmission) {
+    delais[ECHEANCE_INACTIVITE] = (uint64_t) delaiInactivite * 1000;
+    delais[ECHEANCE_ENTETES] = (uint64_t) delaiEntetes * 1000;
+    delais[ECHEANCE_EMISSION] = (uint64_t) delaiEmission * 1000;
+}
+
+/**
+ * @brief Octets emis sur le socket que le client n'a pas encore acquittes, -1 si inconnu
+ */
+static int octetsNonAcquittes(int socket) {
+    int octets = -1;
+
+    if (ioctl(socket, SIOCOUTQ, &octets) < 0) {
+        return -1;
+    }
+
+    return octets;
+}
+
+/**
+ * @brief   Arme la minuterie d'une connexion pour un delai \n
+ *          Note : l'echeance deja armee pour ce meme delai est gardee, sauf pour la prolonger
+ */
+static void surveillerConnexion(Connexion *connexion, EcheanceConnexion echeance, bool prolonger) {
+    if ((connexion->echeance == echeance) && (!(prolonger))) {
+        return;
+    }
+
+    connexion->echeance = echeance;
+    armerMinuterie(&roue, &connexion->minuterie, instantMs() + delais[echeance]);
+
+    // La progression d'une sortie bloquee se mesure aux octets que le client acquitte
+    if (echeance == ECHEANCE_EMISSION) {
+        connexion->nonAcquittes = octetsNonAcquittes(connexion->socket);
+    }
+}
+
+/**
+ * @brief Surveille l'attente des donnees du client : fin de la requete commencee, ou requete suivante
+ */
+static void attendreClient(Connexion *connexion) {
+    // Un client qui emet sa requete octet par octet ne repousse pas l'echeance de ses entetes ;
+    // une connexion neuve doit aussi emettre sa premiere requete dans ce delai
+    if ((connexion->debutTampon != connexion->finTampon) || (connexion->echeance == ECHEANCE_ENTETES)) {
+        surveillerConnexion(connexion, ECHEANCE_ENTETES, FALSE);
+    } else {
+        surveillerConnexion(connexion, ECHEANCE_INACTIVITE, FALSE);
+    }
+}
+
+void configurerMoteur(MoteurReacteur moteurChoisi) {
+    moteur = moteurChoisi;
+}
+
+/**
+ * @brief   Ferme une connexion \n
+ *          Note : si une operation io_uring la designe encore, elle est annulee et la
+ *          connexion n'est liberee qu'a sa completion
+ */
+static void fermerConnexion(Connexion *connexion) {
+    struct io_uring_sqe *soumission = NULL;
+
+    if (!(connexion->operationEnCours)) {
+        TerminaisonClient(connexion);
+        return;
+    }
+
+    if (connexion->annulee) {
+        return;
+    }
+
+    desarmerMinuterie(&connexion->minuterie);
+    connexion->annulee = TRUE;
+
+    if ((soumission = prendreSoumission(anneauCourant)) != NULL) {
+        soumission->opcode = IORING_OP_ASYNC_CANCEL;
+        soumission->fd = connexion->socket;
+        soumission->cancel_flags = IORING_ASYNC_CANCEL_FD;
+        soumission->user_data = OPERATION_ANNULATION;
+    } else {
+        // File de soumission pleine : couper le socket termine aussi la reception en attente
+        shutdown(connexion->socket, SHUT_RDWR);
+    }
+}
+
+/**
+ * @brief Ferme une connexion dont le delai surveille est ecoule
+ */
+static void expirerConnexion(Minuterie *minuterie) {
+    // La minuterie est incluse dans la connexion, on retrouve la structure qui la contient
+    Connexion *connexion = (Connexion *) (void *) ((char *) minuterie - offsetof(Connexion, minuterie));
+
+    // Un client qui lit lentement acquitte encore des octets sans liberer assez de place pour
+    // signaler le socket inscriptible : sa sortie progresse, le delai repart
+    if ((connexion->echeance == ECHEANCE_EMISSION) &&
+        (octetsNonAcquittes(connexion->socket) < connexion->nonAcquittes)) {
+        surveillerConnexion(connexion, ECHEANCE_EMISSION, TRUE);
+        return;
+    }
+
+    compterExpiration(connexion->echeance);
+
+    // Une requete commencee recoit une reponse, en un seul essai : la sortie est vide, rien ne la precede
+    if ((connexion->echeance == ECHEANCE_ENTETES) && (connexion->debutTampon != connexion->finTampon) &&
+        (envoyerErreur(connexion, ERREUR_408))) {
+        viderSortie(connexion);
+    }
+
+    fermerConnexion(connexion);
+}
+
+/**
+ * @brief   Suspend les acceptations, faute de descripteurs ou de memoire : les clients
+ *          attendent dans la file du socket d'ecoute au lieu d'etre acceptes puis perdus \n
+ *          Note : le socket d'ecoute n'est plus surveille par epoll, s'il l'etait
+ */
+static void suspendreAcceptation(int epollFd, int erreur) {
+    struct epoll_event evenement;
+
+    fprintf(stderr, "Acceptations suspendues pendant %d ms : %s\n", PAUSE_ACCEPTATION_MS, strerror(erreur));
+    repriseAcceptation = instantMs() + PAUSE_ACCEPTATION_MS;
+    compterPauseAcceptation();
+
+    if (epollFd >= 0) {
+        evenement.events = 0;
+        evenement.data.ptr = NULL;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, socketEcouteServeur(), &evenement);
+    }
+}
+
+/**
+ * @brief Accepte tous les clients en attente et les inscrit dans epoll
+ */
+static void accepterClients(int epollFd) {
+    Connexion *connexion = NULL;
+    struct epoll_event evenement;
+
+    // En mode edge-triggered il faut vider la file d'attente du socket d'ecoute
+    while ((connexion = AttenteClient()) != NULL) {
+        evenement.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        evenement.data.ptr = connexion;
+        surveillerConnexion(connexion, ECHEANCE_ENTETES, TRUE);
+
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, connexion->socket, &evenement) < 0) {
+            perror("accepterClients, erreur de epoll_ctl.");
+            TerminaisonClient(connexion);
+        }
+    }
+
+    if (acceptationASuspendre(errno)) {
+        suspendreAcceptation(epollFd, errno);
+    }
+}
+
+/**
+ * @brief Reprend les acceptations une fois la pause ecoulee
+ */
+static void reprendreAcceptation(int epollFd) {
+    struct epoll_event evenement;
+
+    repriseAcceptation = 0;
+
+    // Surveiller de nouveau le socket signale aussitot les clients arrives pendant la pause
+    evenement.events = EPOLLIN | EPOLLET;
+    evenement.data.ptr = NULL;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, socketEcouteServeur(), &evenement) < 0) {
+        perror("reprendreAcceptation, erreur de epoll_ctl.");
+    }
+
+    accepterClients(epollFd);
+}
+
+/**
+ * @brief Repond a une requete qui ne tient pas dans le tampon de reception puis ferme la connexion
+ */
+static void refuserDepassement(Connexion *connexion) {
+    // Sans fin de ligne recue, c'est la ligne de requete elle-meme qui deborde
+    bool ligneComplete = memchr(&connexion->tamponClient[connexion->debutTampon], '\n',
+                                connexion->finTampon - connexion->debutTampon) != NULL;
+
+    envoyerErreur(connexion, ligneComplete ? ERREUR_431 : ERREUR_414);
+}
+
+/**
+ * @brief Traite dans l'ordre les requetes completes presentes dans le tampon de reception
+ *
+ * @return bool -> Retourne TRUE si le traitement est suspendu par un corps en cours d'envoi
+ */
+static bool traiterRequetes(Connexion *connexion, TraitementRequete traitement) {
+    Requete requete;
+    ssize_t longueur = 0;
+    // Les requetes d'une rafale sont arrivees ensemble : leur latence compte l'attente des precedentes
+    uint64_t debut = instantUs();
+
+    while (connexion->etat != ETAT_FERMETURE) {
+        // Les reponses doivent partir dans l'ordre : on attend la fin du corps en cours
+        if (reponseEnCours(connexion)) {
+            return TRUE;
+        }
+
+        if (connexion->debutTampon == connexion->finTampon) {
+            return FALSE;
+        }
+
+        TRACE_DEBUT();
+        longueur = analyserRequete(&connexion->tamponClient[connexion->debutTampon],
+                                   connexion->finTampon - connexion->debutTampon,
+                                   &requete, &connexion->repriseAnalyse);
+
+        if (longueur == ANALYSE_INCOMPLETE) {
+            return FALSE;
+        } else if (longueur == ANALYSE_INVALIDE) {
+            // On ne peut plus savoir ou commence la requete suivante : on repond puis on ferme
+            envoyerErreur(connexion, ERREUR_400);
+            mesurerRequete(connexion->statut, debut);
+            return FALSE;
+        }
+
+        TRACE_REQUETE(&requete);
+        commencerReponse(connexion);
+        traitement(connexion, &requete);
+        TRACE_PHASE(PHASE_PREPARATION);
+        journaliserRequete(connexion, &requete, mesurerRequete(connexion->statut, debut));
+
+        // Le client a demande la fermeture : les requetes qui suivent sont ignorees
+        if (demandeFermeture(&requete)) {
+            connexion->etat = ETAT_FERMETURE;
+        }
+
+        // La requete est consommee, la suivante commence juste apres avec ses propres delais
+        connexion->debutTampon += (size_t) longueur;
+        connexion->repriseAnalyse = 0;
+        connexion->echeance = ECHEANCE_AUCUNE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Traite un evenement epoll sur une connexion cliente : alterne traitement
+ *        des requetes recues, emission des reponses et lecture de nouvelles donnees
+ *        jusqu'a ce que le socket soit vide ou plein
+ */
+static void traiterEvenement(Connexion *connexion, uint32_t evenements, TraitementRequete traitement) {
+    ssize_t lu = 0;
+    int retour = 0;
+    bool suspendu = FALSE;
+
+    if (evenements & (EPOLLERR | EPOLLHUP)) {
+        TerminaisonClient(connexion);
+        return;
+    }
+
+    if (evenements & EPOLLIN) {
+        connexion->lisible = TRUE;
+    }
+
+    while (1) {
+        suspendu = traiterRequetes(connexion, traitement);
+
+        // On emet ce qui a ete produit, ou ce qui restait quand le socket etait plein
+        retour = viderSortie(connexion);
+        TRACE_FIN();
+
+        if (retour < 0) {
+            TerminaisonClient(connexion);
+            return;
+        } else if (retour == 0) {
+            // Socket plein : on reprendra sur EPOLLOUT, qui signale que le client a lu
+            surveillerConnexion(connexion, ECHEANCE_EMISSION, (evenements & EPOLLOUT) != 0);
+            return;
+        }
+
+        // Fermeture demandee : on ferme une fois toute la sortie emise
+        if (connexion->etat == ETAT_FERMETURE) {
+            TerminaisonClient(connexion);
+            return;
+        }
+
+        // Le corps vient d'etre emis, des requetes attendent peut-etre deja dans le tampon
+        if (suspendu) {
+            continue;
+        }
+
+        // En mode edge-triggered on lit jusqu'a ce que le socket soit vide
+        if (!(connexion->lisible)) {
+            // En attendant le prochain evenement, la connexion n'a pas besoin de ses tampons
+            attendreClient(connexion);
+            libererTampons(connexion);
+            return;
+        }
+
+        lu = LectureClient(connexion);
+
+        if ((lu < 0) && (errno == ENOBUFS)) {
+            // Le tampon est plein sans qu'une requete complete y figure
+            refuserDepassement(connexion);
+        } else if (lu == 0) {
+            // Le client n'emettra plus rien : on termine d'emettre puis on ferme
+            connexion->etat = ETAT_FERMETURE;
+        } else if (lu < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                TerminaisonClient(connexion);
+                return;
+            }
+            connexion->lisible = FALSE;
+        }
+    }
+}
+
+int lancerReacteur(TraitementRequete traitement) {
+    int epollFd;
+    int nombre, i;
+    struct epoll_event evenement, evenements[MAX_EVENEMENTS];
+
+    if ((epollFd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        perror("lancerReacteur, erreur de epoll_create1.");
+        return 0;
+    }
+
+    // Le socket d'ecoute est repere par un pointeur nul
+    evenement.events = EPOLLIN | EPOLLET;
+    evenement.data.ptr = NULL;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, socketEcouteServeur(), &evenement) < 0) {
+        perror("lancerReacteur, erreur de epoll_ctl.");
+        close(epollFd);
+        return 0;
+    }
+
+    // Les notifications de la racine invalident les resolutions gardees par le travailleur
+    evenement.events = EPOLLIN | EPOLLET;
+    evenement.data.ptr = &repereNotifications;
+
+    if ((notificationsRacine() >= 0) && (epoll_ctl(epollFd, EPOLL_CTL_ADD, notificationsRacine(), &evenement) < 0)) {
+        perror("lancerReacteur, erreur de epoll_ctl.");
+    }
+
+    initialiserRoue(&roue, instantMs());
+
+    while (1) {
+        // Le reacteur se reveille au moins une fois par alveole pour faire tourner la roue
+        nombre = epoll_wait(epollFd, evenements, MAX_EVENEMENTS,
+                            (repriseAcceptation != 0) ? PAUSE_ACCEPTATION_MS : RESOLUTION_ROUE_MS);
+
+        if (nombre < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("lancerReacteur, erreur de epoll_wait.");
+            break;
+        }
+
+        for (i = 0; i < nombre; i++) {
+            if (evenements[i].data.ptr == NULL) {
+                accepterClients(epollFd);
+            } else if (evenements[i].data.ptr == &repereNotifications) {
+                traiterNotifications();
+            } else {
+                traiterEvenement(evenements[i].data.ptr, evenements[i].events, traitement);
+            }
+        }
+
+        // Les connexions sont fermees apres le lot d'evenements qui pourrait encore les designer
+        avancerRoue(&roue, instantMs(), expirerConnexion);
+        actualiserErreurs();
+
+        if ((repriseAcceptation != 0) && (instantMs() >= repriseAcceptation)) {
+            reprendreAcceptation(epollFd);
+        }
+    }
+
+    close(epollFd);
+
+    return 0;
+}
+
+/**
+ * @brief Soumet une operation io_uring portant sur une connexion (ou sur le socket d'ecoute)
+ */
+static struct io_uring_sqe *soumettreOperation(Connexion *connexion, int socket, uint8_t code, uint64_t operation) {
+    struct io_uring_sqe *soumission = NULL;
+
+    if ((soumission = prendreSoumission(anneauCourant)) == NULL) {
+        return NULL;
+    }
+
+    soumission->opcode = code;
+    soumission->fd = socket;
+    soumission->user_data = (uint64_t) (uintptr_t) connexion | operation;
+
+    if (connexion != NULL) {
+        connexion->operationEnCours = TRUE;
+    }
+
+    return soumission;
+}
+
+/**
+ * @brief Acceptation multishot : une seule soumission produit une completion par client
+ */
+static int soumettreAcceptation(void) {
+    struct io_uring_sqe *soumission = NULL;
+
+    if ((soumission = soumettreOperation(NULL, socketEcouteServeur(), IORING_OP_ACCEPT, OPERATION_ACCEPTATION)) == NULL) {
+        return 0;
+    }
+
+    soumission->ioprio = IORING_ACCEPT_MULTISHOT;
+    soumission->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+
+    return 1;
+}
+
+/**
+ * @brief Annule l'acceptation multishot en cours, pendant une pause des acceptations
+ *
+ * @return int -> Retourne 1 si l'annulation est soumise, 0 sinon
+ */
+static int annulerAcceptation(void) {
+    struct io_uring_sqe *soumission = NULL;
+
+    if ((soumission = prendreSoumission(anneauCourant)) == NULL) {
+        return 0;
+    }
+
+    soumission->opcode = IORING_OP_ASYNC_CANCEL;
+    soumission->fd = socketEcouteServeur();
+    soumission->cancel_flags = IORING_ASYNC_CANCEL_FD;
+    soumission->user_data = OPERATION_ANNULATION;
+
+    return 1;
+}
+
+/**
+ * @brief Attente multishot des notifications de la racine
+ */
+static int soumettreNotifications(void) {
+    struct io_uring_sqe *soumission = NULL;
+
+    if ((soumission = soumettreOperation(NULL, notificationsRacine(), IORING_OP_POLL_ADD, OPERATION_NOTIFICATION)) == NULL) {
+        return 0;
+    }
+
+    soumission->len = IORING_POLL_ADD_MULTI;
+    soumission->poll32_events = POLLIN;
+
+    return 1;
+}
+
+/**
+ * @brief Soumet la reception des prochaines donnees du client
+ */
+static void soumettreReception(Connexion *connexion) {
+    struct io_uring_sqe *soumission = NULL;
+
+    if ((soumission = soumettreOperation(connexion, connexion->socket, IORING_OP_RECV, OPERATION_RECEPTION)) == NULL) {
+        TerminaisonClient(connexion);
+        return;
+    }
+
+    if (connexion->tamponClient == NULL) {
+        // Le noyau ne choisit un tampon qu'a l'arrivee des donnees : une connexion
+        // inactive n'en immobilise aucun
+        soumission->flags = IOSQE_BUFFER_SELECT;
+        soumission->buf_group = GROUPE_TAMPONS_ANNEAU;
+    } else {
+        // La suite d'une requete partielle est recue directement a sa place
+        soumission->addr = (uint64_t) (uintptr_t) &connexion->tamponClient[connexion->finTampon];
+        soumission->len = (uint32_t) (LONGUEUR_TAMPON - connexion->finTampon);
+    }
+}
+
+/**
+ * @brief   Traite les requetes recues et emet les reponses, puis soumet l'operation
+ *          qui permettra de continuer : attente du socket plein ou reception suivante
+ *
+ * @param inscriptible  TRUE si le socket vient d'etre signale inscriptible : la sortie a progresse
+ */
+static void poursuivreConnexion(Connexion *connexion, TraitementRequete traitement, bool inscriptible) {
+    struct io_uring_sqe *soumission = NULL;
+    int retour = 0;
+    bool suspendu = FALSE;
+
+    while (1) {
+        suspendu = traiterRequetes(connexion, traitement);
+
+        retour = viderSortie(connexion);
+        TRACE_FIN();
+
+        if (retour < 0) {
+            fermerConnexion(connexion);
+            return;
+        } else if (retour == 0) {
+            // Socket plein : io_uring nous previendra quand il sera de nouveau inscriptible
+            if ((soumission = soumettreOperation(connexion, connexion->socket, IORING_OP_POLL_ADD,
+                                                 OPERATION_EMISSION)) == NULL) {
+                TerminaisonClient(connexion);
+                return;
+            }
+            soumission->poll32_events = POLLOUT;
+            surveillerConnexion(connexion, ECHEANCE_EMISSION, inscriptible);
+            return;
+        }
+
+        if (connexion->etat == ETAT_FERMETURE) {
+            fermerConnexion(connexion);
+            return;
+        }
+
+        if (suspendu) {
+            continue;
+        }
+
+        // Rien en attente : les tampons retournent aux reserves pendant l'attente
+        if (connexion->debutTampon == connexion->finTampon) {
+            libererTampons(connexion);
+        } else if (!(preparerReception(connexion))) {
+            if (errno != ENOBUFS) {
+                fermerConnexion(connexion);
+                return;
+            }
+            refuserDepassement(connexion);
+            continue;
+        }
+
+        attendreClient(connexion);
+        soumettreReception(connexion);
+        return;
+    }
+}
+
+/**
+ * @brief Traite la completion d'une reception : donnees recues, fin de connexion ou erreur
+ */
+static void terminerReception(Connexion *connexion, int32_t resultat, uint32_t drapeaux, TraitementRequete traitement) {
+    unsigned identifiant;
+
+    if (drapeaux & IORING_CQE_F_BUFFER) {
+        // Les donnees sont recopiees dans le tampon de la connexion pour rendre vite le tampon fourni
+        identifiant = drapeaux >> IORING_CQE_BUFFER_SHIFT;
+
+        if ((resultat > 0) && (!(connexion->annulee))) {
+            if (preparerReception(connexion)) {
+                memcpy(&connexion->tamponClient[connexion->finTampon], tamponFourni(anneauCourant, identifiant),
+                       (size_t) resultat);
+                connexion->finTampon += (size_t) resultat;
+            } else {
+                resultat = -ENOMEM;
+            }
+        }
+
+        rendreTampon(anneauCourant, identifiant);
+    } else if (resultat > 0) {
+        connexion->finTampon += (size_t) resultat;
+    }
+
+    if (connexion->annulee) {
+        TerminaisonClient(connexion);
+        return;
+    }
+
+    if (resultat == -ENOBUFS) {
+        // Tous les tampons fournis sont pris : on recoit dans celui de la connexion
+        if (!(preparerReception(connexion))) {
+            fermerConnexion(connexion);
+            return;
+        }
+        soumettreReception(connexion);
+        return;
+    } else if (resultat == 0) {
+        // Le client n'emettra plus rien : on termine d'emettre puis on ferme
+        connexion->etat = ETAT_FERMETURE;
+    } else if (resultat < 0) {
+        fermerConnexion(connexion);
+        return;
+    }
+
+    poursuivreConnexion(connexion, traitement, FALSE);
+}
+
+/**
+ * @brief Aiguille une completion vers le traitement de l'operation qu'elle termine
+ */
+static void traiterCompletion(uint64_t donnees, int32_t resultat, uint32_t drapeaux, TraitementRequete traitement) {
+    Connexion *connexion = (Connexion *) (uintptr_t) (donnees & ~(uint64_t) MASQUE_OPERATION);
+
+    switch (donnees & MASQUE_OPERATION) {
+        case OPERATION_ACCEPTATION:
+            if (resultat == -ECANCELED) {
+                // Acceptation annulee par une pause : la reprise la relancera
+                break;
+            } else if (resultat < 0) {
+                compterAcceptationEchouee();
+            } else if ((connexion = ouvrirConnexion(resultat, NULL, 0)) != NULL) {
+                surveillerConnexion(connexion, ECHEANCE_ENTETES, TRUE);
+                poursuivreConnexion(connexion, traitement, FALSE);
+            } else if ((acceptationASuspendre(errno)) && (repriseAcceptation == 0) &&
+                       ((!(drapeaux & IORING_CQE_F_MORE)) || (annulerAcceptation()))) {
+                // Le client a ete refuse (503) ; les suivants attendent dans la file du socket d'ecoute
+                suspendreAcceptation(-1, errno);
+                break;
+            }
+
+            // L'acceptation multishot peut s'arreter (erreur, manque de memoire) : on la relance,
+            // apres une pause si les descripteurs ou la memoire manquent
+            if ((drapeaux & IORING_CQE_F_MORE) || (repriseAcceptation != 0)) {
+                break;
+            }
+            if ((resultat < 0) && (acceptationASuspendre(-resultat))) {
+                suspendreAcceptation(-1, -resultat);
+            } else if (!(soumettreAcceptation())) {
+                fprintf(stderr, "traiterCompletion, impossible de relancer l'acceptation\n");
+            }
+            break;
+        case OPERATION_RECEPTION:
+            connexion->operationEnCours = FALSE;
+            terminerReception(connexion, resultat, drapeaux, traitement);
+            break;
+        case OPERATION_EMISSION:
+            connexion->operationEnCours = FALSE;
+            if (connexion->annulee) {
+                TerminaisonClient(connexion);
+            } else {
+                poursuivreConnexion(connexion, traitement, TRUE);
+            }
+            break;
+        case OPERATION_NOTIFICATION:
+            traiterNotifications();
+
+            if ((!(drapeaux & IORING_CQE_F_MORE)) && (!(soumettreNotifications()))) {
+                fprintf(stderr, "traiterCompletion, impossible de relancer l'attente des notifications\n");
+            }
+            break;
+        default:
+            // Resultat d'une annulation : la connexion sera liberee par la completion annulee
+            break;
+    }
+}
+
+int lancerReacteurAnneau(TraitementRequete traitement) {
+    Anneau anneau;
+    struct io_uring_cqe *completion = NULL;
+    uint64_t donnees;
+    int32_t resultat;
+    uint32_t drapeaux;
+
+    if (!(initialiserAnneau(&anneau))) {
+        return 0;
+    }
+
+    anneauCourant = &anneau;
+    initialiserRoue(&roue, instantMs());
+
+    if ((notificationsRacine() >= 0) && (!(soumettreNotifications()))) {
+        fprintf(stderr, "lancerReacteurAnneau, impossible d'attendre les notifications\n");
+    }
+
+    if (soumettreAcceptation()) {
+        // Une seule entree dans le noyau par tour soumet et recupere tout le lot
+        while (soumettreEtAttendre(&anneau, (repriseAcceptation != 0) ? PAUSE_ACCEPTATION_MS : RESOLUTION_ROUE_MS)) {
+            while ((completion = prochaineCompletion(&anneau)) != NULL) {
+                // La completion est recopiee : son emplacement peut etre reutilise par le noyau
+                donnees = completion->user_data;
+                resultat = completion->res;
+                drapeaux = completion->flags;
+                consommerCompletion(&anneau);
+
+                traiterCompletion(donnees, resultat, drapeaux, traitement);
+            }
+
+            avancerRoue(&roue, instantMs(), expirerConnexion);
+            actualiserErreurs();
+
+            if ((repriseAcceptation != 0) && (instantMs() >= repriseAcceptation)) {
+                repriseAcceptation = 0;
+                if (!(soumettreAcceptation())) {
+                    fprintf(stderr, "lancerReacteurAnneau, impossible de relancer l'acceptation\n");
+                }
+            }
+        }
+    }
+
+    anneauCourant = NULL;
+    terminerAnneau(&anneau);
+
+    return 1;
+}
+
+/**
+ * @brief Corps d'un thread travailleur : socket d'ecoute et reacteur qui lui sont propres
+ */
+static void *travailleur(void *arg) {
+    ParametresTravailleur *parametres = arg;
+
+    if ((!(inscrireMesures())) || (!(inscrireJournal())) || (!(initialiserDescripteurs())) ||
+        (!(chargerErreurs())) || (!(InitialisationAvecService(parametres->service)))) {
+        return NULL;
+    }
+
+    TRACE_INSCRIRE();
+
+    // Sans io_uring dans le noyau, le travailleur se rabat sur epoll
+    if ((moteur != MOTEUR_IO_URING) || (!(lancerReacteurAnneau(parametres->traitement)))) {
+        if (moteur == MOTEUR_IO_URING) {
+            fprintf(stderr, "io_uring indisponible, utilisation de epoll\n");
+        }
+        lancerReacteur(parametres->traitement);
+    }
+    Terminaison();
+
+    return NULL;
+}
+
+int lancerTravailleurs(char *service, int nombreTravailleurs, TraitementRequete traitement) {
+    ParametresTravailleur parametres;
+    pthread_t *threads = NULL;
+    int i, lances = 0;
+
+    parametres.service = service;
+    parametres.traitement = traitement;
+
+    if ((threads = calloc((size_t) nombreTravailleurs, sizeof(pthread_t))) == NULL) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        return 0;
+    }
+
+    for (i = 0; i < nombreTravailleurs; i++) {
+        if (pthread_create(&threads[lances], NULL, travailleur, &parametres) != 0) {
+            fprintf(stderr, "lancerTravailleurs, impossible de creer le travailleur %d\n", i);
+            continue;
+        }
+        lances++;
+    }
+
+    // Les travailleurs ne s'arretent qu'en cas d'erreur fatale de leur reacteur
+    for (i = 0; i < lances; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file    reacteur.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de la boucle evenementielle du serveur \n
+ *          Le reacteur surveille le socket d'ecoute et toutes les connexions
+ *          clientes avec epoll en mode declenche sur front (edge-triggered),
+ *          ou les confie a io_uring : acceptation multishot et receptions
+ *          dans des tampons fournis, soumises par lots a chaque tour.
+ * @version 1.2
+ * @date    2020-12-13
+ * 
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __REACTEUR_H__
+#define __REACTEUR_H__
+
+#include "anneau.h"
+#include "serveur.h"
+#include "requete.h"
+
+#include <pthread.h>
+#include <sys/epoll.h>
+
+/* Nombre maximal d'evenements recuperes par appel a epoll_wait */
+#define MAX_EVENEMENTS 256
+/* Duree par defaut au bout de laquelle une connexion inactive est fermee, en secondes */
+#define DELAI_INACTIVITE_DEFAUT 15
+/* Duree par defaut accordee a un client pour emettre une requete complete, en secondes */
+#define DELAI_ENTETES_DEFAUT 10
+/* Duree par defaut pendant laquelle une sortie peut rester bloquee sans progresser, en secondes */
+#define DELAI_EMISSION_DEFAUT 30
+/* Delai maximal accepte pour chacun des delais precedents, en secondes */
+#define DELAI_MAXIMAL 3600
+
+/**
+ * @brief Mecanisme d'attente des evenements utilise par les travailleurs
+ */
+typedef enum {
+    MOTEUR_EPOLL,
+    MOTEUR_IO_URING
+} MoteurReacteur;
+
+/**
+ * @brief   Fonction appelee par le reacteur pour chaque requete complete \n
+ *          Note : les tranches de la requete ne sont valides que pendant l'appel
+ * 
+ * @param connexion Connexion du client qui a emis la requete
+ * @param requete   Requete analysee
+ */
+typedef void (*TraitementRequete)(Connexion *connexion, const Requete *requete);
+
+/**
+ * @brief   Fixe les delais au-dela desquels une connexion est fermee \n
+ *          Note : a appeler avant le demarrage des travailleurs ; un client qui n'a
+ *          pas fini d'emettre sa requete a temps recoit une reponse 408
+ * 
+ * @param delaiInactivite   Attente d'une nouvelle requete en secondes, DELAI_INACTIVITE_DEFAUT par defaut
+ * @param delaiEntetes      Reception d'une requete depuis son premier octet (ou depuis la connexion
+ *                          pour la premiere) en secondes, DELAI_ENTETES_DEFAUT par defaut
+ * @param delaiEmission     Sortie bloquee sans qu'aucun octet ne parte en secondes,
+ *                          DELAI_EMISSION_DEFAUT par defaut
+ */
+void configurerReacteur(int delaiInactivite, int delaiEntetes, int delaiEmission);
+
+/**
+ * @brief   Choisit le mecanisme d'attente des travailleurs, epoll par defaut \n
+ *          Note : un travailleur revient a epoll si le noyau ne permet pas io_uring
+ * 
+ * @param moteur    Mecanisme a utiliser
+ */
+void configurerMoteur(MoteurReacteur moteur);
+
+/**
+ * @brief Boucle evenementielle : accepte les clients et traite leurs requetes
+ *        sans jamais bloquer sur l'un d'eux
+ * 
+ * @param traitement    Fonction de traitement des requetes
+ * @return              int -> Retourne 0 si le reacteur n'a pas pu demarrer, ne retourne pas sinon
+ */
+int lancerReacteur(TraitementRequete traitement);
+
+/**
+ * @brief   Boucle evenementielle sur io_uring : une seule entree dans le noyau par tour
+ *          soumet toutes les operations preparees et recupere toutes les completions \n
+ *          Note : les corps de reponse restent emis par sendmsg et sendfile, io_uring
+ *          signale seulement quand le socket peut de nouveau les accepter
+ * 
+ * @param traitement    Fonction de traitement des requetes
+ * @return              int -> Retourne 0 si io_uring n'est pas disponible, 1 apres une erreur fatale
+ */
+int lancerReacteurAnneau(TraitementRequete traitement);
+
+/**
+ * @brief   Demarre plusieurs travailleurs, chacun dans son thread avec son propre
+ *          socket d'ecoute (SO_REUSEPORT) et son propre reacteur \n
+ *          Note : les connexions ne sont jamais partagees entre travailleurs
+ * 
+ * @param service               Numero de port sur lequel ecouter
+ * @param nombreTravailleurs    Nombre de threads travailleurs a lancer
+ * @param traitement            Fonction de traitement des requetes
+ * @return                      int -> Retourne 0 si aucun travailleur n'a pu demarrer, ne retourne pas sinon
+ */
+int lancerTravailleurs(char *service, int nombreTravailleurs, TraitementRequete traitement);
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * @file    recherche.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source des fonctions de recherche de delimiteurs \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "recherche.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RECHERCHE_VECTORIELLE 1
+#include <immintrin.h>
+#else
+#define RECHERCHE_VECTORIELLE 0
+#endif
+
+/**
+ * @brief Indique si un octet arrete la recherche de chercherControle
+ */
+static bool estArret(unsigned char c, bool arretEspace) {
+    return ((c < 0x20) && (c != '\t')) || (c == 0x7f) || (arretEspace && (c == ' '));
+}
+
+/**
+ * @brief Recherche d'un octet, un octet a la fois
+ */
+static size_t chercherOctetScalaire(const char *tampon, size_t taille, char octet) {
+    size_t i;
+
+    for (i = 0; i < taille; i++) {
+        if (tampon[i] == octet) {
+            return i;
+        }
+    }
+
+    return taille;
+}
+
+/**
+ * @brief Recherche d'un caractere de controle, un octet a la fois
+ */
+static size_t chercherControleScalaire(const char *tampon, size_t taille, bool arretEspace) {
+    size_t i;
+
+    for (i = 0; i < taille; i++) {
+        if (estArret((unsigned char) tampon[i], arretEspace)) {
+            return i;
+        }
+    }
+
+    return taille;
+}
+
+#if RECHERCHE_VECTORIELLE
+
+/**
+ * @brief Recherche d'un octet par blocs de 16 (comparaison puis masque des resultats)
+ */
+__attribute__((target("sse4.2")))
+static size_t chercherOctetSse42(const char *tampon, size_t taille, char octet) {
+    const __m128i cible = _mm_set1_epi8(octet);
+    size_t i = 0;
+    int masque;
+
+    for (; i + 16 <= taille; i += 16) {
+        __m128i bloc = _mm_loadu_si128((const __m128i *) (const void *) &tampon[i]);
+
+        if ((masque = _mm_movemask_epi8(_mm_cmpeq_epi8(bloc, cible))) != 0) {
+            return i + (size_t) __builtin_ctz((unsigned int) masque);
+        }
+    }
+
+    // Les derniers octets ne remplissent pas un bloc entier
+    return i + chercherOctetScalaire(&tampon[i], taille - i, octet);
+}
+
+/**
+ * @brief Recherche d'un caractere de controle par blocs de 16 avec PCMPESTRI sur des plages
+ */
+__attribute__((target("sse4.2")))
+static size_t chercherControleSse42(const char *tampon, size_t taille, bool arretEspace) {
+    // Plages d'octets qui arretent la recherche : [0x00-0x08] [0x0a-0x1f ou 0x20] [0x7f]
+    static const char plagesControle[16] = {0x00, 0x08, 0x0a, 0x1f, 0x7f, 0x7f};
+    static const char plagesEspace[16] = {0x00, 0x08, 0x0a, 0x20, 0x7f, 0x7f};
+    const __m128i plages = _mm_loadu_si128((const __m128i *) (const void *) (arretEspace ? plagesEspace : plagesControle));
+    size_t i = 0;
+    int position;
+
+    for (; i + 16 <= taille; i += 16) {
+        __m128i bloc = _mm_loadu_si128((const __m128i *) (const void *) &tampon[i]);
+
+        position = _mm_cmpestri(plages, 6, bloc, 16,
+                                _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+
+        if (position < 16) {
+            return i + (size_t) position;
+        }
+    }
+
+    return i + chercherControleScalaire(&tampon[i], taille - i, arretEspace);
+}
+
+/**
+ * @brief Recherche d'un octet par blocs de 32
+ */
+__attribute__((target("avx2")))
+static size_t chercherOctetAvx2(const char *tampon, size_t taille, char octet) {
+    const __m256i cible = _mm256_set1_epi8(octet);
+    size_t i = 0;
+    int masque;
+
+    for (; i + 32 <= taille; i += 32) {
+        __m256i bloc = _mm256_loadu_si256((const __m256i *) (const void *) &tampon[i]);
+
+        if ((masque = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bloc, cible))) != 0) {
+            return i + (size_t) __builtin_ctz((unsigned int) masque);
+        }
+    }
+
+    return i + chercherOctetScalaire(&tampon[i], taille - i, octet);
+}
+
+/**
+ * @brief Recherche d'un caractere de controle par blocs de 32
+ */
+__attribute__((target("avx2")))
+static size_t chercherControleAvx2(const char *tampon, size_t taille, bool arretEspace) {
+    const __m256i maxControle = _mm256_set1_epi8(0x1f);
+    const __m256i tabulation = _mm256_set1_epi8('\t');
+    const __m256i suppression = _mm256_set1_epi8(0x7f);
+    const __m256i espace = _mm256_set1_epi8(' ');
+    size_t i = 0;
+    int masque;
+
+    for (; i + 32 <= taille; i += 32) {
+        __m256i bloc = _mm256_loadu_si256((const __m256i *) (const void *) &tampon[i]);
+        // Un octet est inferieur ou egal a 0x1f si le minimum des deux vaut l'octet lui-meme
+        __m256i controle = _mm256_cmpeq_epi8(_mm256_min_epu8(bloc, maxControle), bloc);
+        __m256i arret = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(bloc, tabulation), controle),
+                                        _mm256_cmpeq_epi8(bloc, suppression));
+
+        if (arretEspace) {
+            arret = _mm256_or_si256(arret, _mm256_cmpeq_epi8(bloc, espace));
+        }
+
+        if ((masque = _mm256_movemask_epi8(arret)) != 0) {
+            return i + (size_t) __builtin_ctz((unsigned int) masque);
+        }
+    }
+
+    return i + chercherControleScalaire(&tampon[i], taille - i, arretEspace);
+}
+
+#endif
+
+/* Implementations retenues, fixees au demarrage puis en lecture seule */
+static size_t (*implementationOctet)(const char *, size_t, char) = chercherOctetScalaire;
+static size_t (*implementationControle)(const char *, size_t, bool) = chercherControleScalaire;
+
+NiveauRecherche initialiserRecherche(NiveauRecherche niveauMax) {
+    NiveauRecherche niveau = RECHERCHE_SCALAIRE;
+
+#if RECHERCHE_VECTORIELLE
+    __builtin_cpu_init();
+
+    if ((niveauMax >= RECHERCHE_AVX2) && (__builtin_cpu_supports("avx2"))) {
+        niveau = RECHERCHE_AVX2;
+    } else if ((niveauMax >= RECHERCHE_SSE42) && (__builtin_cpu_supports("sse4.2"))) {
+        niveau = RECHERCHE_SSE42;
+    }
+#else
+    (void) niveauMax;
+#endif
+
+    switch (niveau) {
+#if RECHERCHE_VECTORIELLE
+        case RECHERCHE_AVX2:
+            implementationOctet = chercherOctetAvx2;
+            implementationControle = chercherControleAvx2;
+            break;
+        case RECHERCHE_SSE42:
+            implementationOctet = chercherOctetSse42;
+            implementationControle = chercherControleSse42;
+            break;
+#endif
+        default:
+            implementationOctet = chercherOctetScalaire;
+            implementationControle = chercherControleScalaire;
+            break;
+    }
+
+    return niveau;
+}
+
+const char *nomRecherche(NiveauRecherche niveau) {
+    switch (niveau) {
+        case RECHERCHE_AVX2:
+            return "avx2";
+        case RECHERCHE_SSE42:
+            return "sse4.2";
+        default:
+            return "scalaire";
+    }
+}
+
+size_t chercherOctet(const char *tampon, size_t taille, char octet) {
+    return implementationOctet(tampon, taille, octet);
+}
+
+size_t chercherControle(const char *tampon, size_t taille, bool arretEspace) {
+    return implementationControle(tampon, taille, arretEspace);
+}
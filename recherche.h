@@ -0,0 +1,69 @@
+/**
+ * @file    recherche.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration des fonctions de recherche de delimiteurs \n
+ *          Les fins de ligne et les separateurs des requetes sont cherches
+ *          par blocs de 16 ou 32 octets (SSE4.2, AVX2) quand le processeur
+ *          le permet, avec une version octet par octet sinon. Les fonctions
+ *          renvoient des positions dans le tampon, sans rien copier.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __RECHERCHE_H__
+#define __RECHERCHE_H__
+
+#include "serveur.h"
+
+/**
+ * @brief Jeux d'instructions utilisables pour la recherche, du moins au plus rapide
+ */
+typedef enum {
+    RECHERCHE_SCALAIRE,
+    RECHERCHE_SSE42,
+    RECHERCHE_AVX2
+} NiveauRecherche;
+
+/**
+ * @brief   Choisit la meilleure implementation supportee par le processeur \n
+ *          Note : a appeler avant le demarrage des travailleurs, la version
+ *          scalaire est utilisee tant que ce n'est pas fait
+ *
+ * @param niveauMax Niveau le plus eleve autorise (utile pour comparer les implementations)
+ * @return          NiveauRecherche -> Retourne le niveau retenu
+ */
+NiveauRecherche initialiserRecherche(NiveauRecherche niveauMax);
+
+/**
+ * @brief Nom lisible d'un niveau de recherche
+ *
+ * @param niveau    Niveau de recherche
+ * @return          const char* -> Retourne le nom du jeu d'instructions
+ */
+const char *nomRecherche(NiveauRecherche niveau);
+
+/**
+ * @brief Recherche la premiere occurrence d'un octet
+ *
+ * @param tampon    Donnees a parcourir
+ * @param taille    Nombre d'octets a parcourir
+ * @param octet     Octet recherche
+ * @return          size_t -> Retourne la position de l'octet, taille s'il est absent
+ */
+size_t chercherOctet(const char *tampon, size_t taille, char octet);
+
+/**
+ * @brief   Recherche le premier caractere de controle (tabulation exceptee),
+ *          et si demande le premier espace \n
+ *          Note : sert a trouver la fin d'une valeur d'entete ou de la cible
+ *
+ * @param tampon        Donnees a parcourir
+ * @param taille        Nombre d'octets a parcourir
+ * @param arretEspace   TRUE pour s'arreter aussi sur un espace
+ * @return              size_t -> Retourne la position trouvee, taille si aucune
+ */
+size_t chercherControle(const char *tampon, size_t taille, bool arretEspace);
+
+#endif
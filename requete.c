@@ -0,0 +1,390 @@
+/**
+ * @file    requete.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source de l'analyseur de requetes HTTP/1.1 \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "recherche.h"
+#include "requete.h"
+
+/* Caracteres pouvant faire partie d'un jeton (methode, nom d'entete), indexes par octet */
+static const unsigned char caracteresJeton[256] = {
+    ['!'] = 1, ['#'] = 1, ['$'] = 1, ['%'] = 1, ['&'] = 1, ['\''] = 1, ['*'] = 1, ['+'] = 1,
+    ['-'] = 1, ['.'] = 1, ['^'] = 1, ['_'] = 1, ['`'] = 1, ['|'] = 1, ['~'] = 1,
+    ['0'] = 1, ['1'] = 1, ['2'] = 1, ['3'] = 1, ['4'] = 1, ['5'] = 1, ['6'] = 1, ['7'] = 1, ['8'] = 1, ['9'] = 1,
+    ['A'] = 1, ['B'] = 1, ['C'] = 1, ['D'] = 1, ['E'] = 1, ['F'] = 1, ['G'] = 1, ['H'] = 1, ['I'] = 1,
+    ['J'] = 1, ['K'] = 1, ['L'] = 1, ['M'] = 1, ['N'] = 1, ['O'] = 1, ['P'] = 1, ['Q'] = 1, ['R'] = 1,
+    ['S'] = 1, ['T'] = 1, ['U'] = 1, ['V'] = 1, ['W'] = 1, ['X'] = 1, ['Y'] = 1, ['Z'] = 1,
+    ['a'] = 1, ['b'] = 1, ['c'] = 1, ['d'] = 1, ['e'] = 1, ['f'] = 1, ['g'] = 1, ['h'] = 1, ['i'] = 1,
+    ['j'] = 1, ['k'] = 1, ['l'] = 1, ['m'] = 1, ['n'] = 1, ['o'] = 1, ['p'] = 1, ['q'] = 1, ['r'] = 1,
+    ['s'] = 1, ['t'] = 1, ['u'] = 1, ['v'] = 1, ['w'] = 1, ['x'] = 1, ['y'] = 1, ['z'] = 1
+};
+
+/**
+ * @brief Indique si un caractere peut faire partie d'un jeton (methode, nom d'entete)
+ */
+static bool estCaractereJeton(char c) {
+    return caracteresJeton[(unsigned char) c];
+}
+
+/**
+ * @brief Recherche la ligne vide qui termine les entetes
+ *
+ * @return size_t -> Position qui suit la ligne vide, 0 si elle n'a pas encore ete recue
+ */
+static size_t chercherFinEntetes(const char *tampon, size_t taille, size_t *reprise) {
+    size_t i = *reprise;
+
+    // On saute d'une fin de ligne a la suivante sans examiner les octets intermediaires
+    while ((i += chercherOctet(&tampon[i], taille - i, '\n')) < taille) {
+        if ((i + 1 < taille) && (tampon[i + 1] == '\n')) {
+            return i + 2;
+        }
+
+        if ((i + 2 < taille) && (tampon[i + 1] == '\r') && (tampon[i + 2] == '\n')) {
+            return i + 3;
+        }
+
+        i++;
+    }
+
+    // Les deux derniers octets peuvent etre le debut de la ligne vide
+    *reprise = (taille > 2) ? taille - 2 : 0;
+
+    return 0;
+}
+
+/**
+ * @brief Consomme une fin de ligne LF ou CRLF
+ *
+ * @return bool -> Retourne FALSE si aucune fin de ligne n'est a la position courante
+ */
+static bool consommerFinLigne(const char **position, const char *fin) {
+    if ((*position < fin) && (**position == '\r')) {
+        (*position)++;
+    }
+
+    if ((*position < fin) && (**position == '\n')) {
+        (*position)++;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Analyse la ligne de requete : methode, cible et version separees par un espace
+ */
+static bool analyserLigneRequete(const char **position, const char *fin, Requete *requete) {
+    const char *p = *position;
+
+    requete->methode.debut = p;
+    while ((p < fin) && (estCaractereJeton(*p))) {
+        p++;
+    }
+    requete->methode.longueur = (size_t) (p - requete->methode.debut);
+
+    if ((requete->methode.longueur == 0) || (p == fin) || (*p++ != ' ')) {
+        return FALSE;
+    }
+
+    requete->cible.debut = p;
+    p += chercherControle(p, (size_t) (fin - p), TRUE);
+    requete->cible.longueur = (size_t) (p - requete->cible.debut);
+
+    if ((requete->cible.longueur == 0) || (p == fin) || (*p++ != ' ')) {
+        return FALSE;
+    }
+
+    requete->version.debut = p;
+    p += chercherControle(p, (size_t) (fin - p), FALSE);
+    requete->version.longueur = (size_t) (p - requete->version.debut);
+
+    // La version a toujours la forme HTTP/x.y
+    if ((requete->version.longueur != 8) || (strncmp(requete->version.debut, "HTTP/", 5) != 0)) {
+        return FALSE;
+    }
+
+    *position = p;
+
+    return consommerFinLigne(position, fin);
+}
+
+/**
+ * @brief Analyse une ligne d'entete "Nom: valeur" en retirant les espaces autour de la valeur
+ */
+static bool analyserEntete(const char **position, const char *fin, Entete *entete) {
+    const char *p = *position;
+    const char *finValeur = NULL;
+
+    entete->nom.debut = p;
+    while ((p < fin) && (estCaractereJeton(*p))) {
+        p++;
+    }
+    entete->nom.longueur = (size_t) (p - entete->nom.debut);
+
+    if ((entete->nom.longueur == 0) || (p == fin) || (*p++ != ':')) {
+        return FALSE;
+    }
+
+    while ((p < fin) && ((*p == ' ') || (*p == '\t'))) {
+        p++;
+    }
+
+    // Seule la tabulation est admise parmi les caracteres de controle : le premier
+    // trouve doit etre la fin de ligne, sinon consommerFinLigne echouera
+    entete->valeur.debut = p;
+    p += chercherControle(p, (size_t) (fin - p), FALSE);
+
+    finValeur = p;
+    while ((finValeur > entete->valeur.debut) && ((finValeur[-1] == ' ') || (finValeur[-1] == '\t'))) {
+        finValeur--;
+    }
+    entete->valeur.longueur = (size_t) (finValeur - entete->valeur.debut);
+
+    *position = p;
+
+    return consommerFinLigne(position, fin);
+}
+
+ssize_t analyserRequete(const char *tampon, size_t taille, Requete *requete, size_t *reprise) {
+    const char *p = tampon;
+    const char *fin = NULL;
+    size_t ignore = 0;
+    size_t longueur = 0;
+
+    // Des lignes vides peuvent preceder la ligne de requete, on les ignore
+    while ((ignore < taille) && ((tampon[ignore] == '\r') || (tampon[ignore] == '\n'))) {
+        ignore++;
+    }
+
+    if (*reprise < ignore) {
+        *reprise = ignore;
+    }
+
+    // On n'analyse rien tant que la requete n'est pas arrivee en entier
+    if ((longueur = chercherFinEntetes(tampon, taille, reprise)) == 0) {
+        return ANALYSE_INCOMPLETE;
+    }
+
+    p = tampon + ignore;
+    fin = tampon + longueur;
+    requete->nombreEntetes = 0;
+
+    if (!(analyserLigneRequete(&p, fin, requete))) {
+        return ANALYSE_INVALIDE;
+    }
+
+    // Les entetes se succedent jusqu'a la ligne vide
+    while (!(consommerFinLigne(&p, fin))) {
+        if (requete->nombreEntetes == MAX_ENTETES) {
+            return ANALYSE_INVALIDE;
+        }
+
+        if (!(analyserEntete(&p, fin, &requete->entetes[requete->nombreEntetes]))) {
+            return ANALYSE_INVALIDE;
+        }
+
+        requete->nombreEntetes++;
+    }
+
+    return (ssize_t) longueur;
+}
+
+bool trancheEgale(const Tranche *tranche, const char *chaine) {
+    return (strlen(chaine) == tranche->longueur) && (!(memcmp(tranche->debut, chaine, tranche->longueur)));
+}
+
+bool trancheEgaleCasse(const Tranche *tranche, const char *chaine) {
+    return (strlen(chaine) == tranche->longueur) && (!(strncasecmp(tranche->debut, chaine, tranche->longueur)));
+}
+
+const Tranche *chercherEntete(const Requete *requete, const char *nom) {
+    size_t i;
+
+    for (i = 0; i < requete->nombreEntetes; i++) {
+        if (trancheEgaleCasse(&requete->entetes[i].nom, nom)) {
+            return &requete->entetes[i].valeur;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Recherche un jeton dans une liste separee par des virgules (casse ignoree)
+ */
+static bool contientJeton(const Tranche *liste, const char *jeton) {
+    Tranche element;
+    const char *p = liste->debut;
+    const char *fin = liste->debut + liste->longueur;
+
+    while (p < fin) {
+        while ((p < fin) && ((*p == ' ') || (*p == '\t') || (*p == ','))) {
+            p++;
+        }
+
+        element.debut = p;
+        while ((p < fin) && (*p != ',') && (*p != ' ') && (*p != '\t')) {
+            p++;
+        }
+        element.longueur = (size_t) (p - element.debut);
+
+        if ((element.longueur > 0) && (trancheEgaleCasse(&element, jeton))) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+bool demandeFermeture(const Requete *requete) {
+    const Tranche *connexion = chercherEntete(requete, "Connection");
+
+    if ((connexion != NULL) && (contientJeton(connexion, "close"))) {
+        return TRUE;
+    }
+
+    // Avant HTTP/1.1 la connexion n'est conservee que sur demande explicite
+    return (trancheEgale(&requete->version, "HTTP/1.0")) &&
+           ((connexion == NULL) || (!(contientJeton(connexion, "keep-alive"))));
+}
+
+bool porteCorps(const Requete *requete) {
+    const Tranche *longueur = chercherEntete(requete, "Content-Length");
+
+    return (chercherEntete(requete, "Transfer-Encoding") != NULL) ||
+           ((longueur != NULL) && (!(trancheEgale(longueur, "0"))));
+}
+
+bool verifierRequete(const Requete *requete) {
+    // Seul GET en HTTP/1.1 ou 1.0 sur un chemin absolu est traite par le serveur ; le refus est
+    // compte par le journal des acces, rien n'est ecrit sur stderr pendant une rafale
+    return (trancheEgale(&requete->methode, "GET")) &&
+           ((trancheEgale(&requete->version, "HTTP/1.1")) || (trancheEgale(&requete->version, "HTTP/1.0"))) &&
+           (requete->cible.debut[0] == '/');
+}
+
+/**
+ * @brief Valeur d'un chiffre hexadecimal, -1 si le caractere n'en est pas un
+ */
+static int valeurHexadecimale(char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+
+    if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+
+    if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Ajoute un segment decode au chemin normalise, en appliquant "." et ".."
+ *
+ * @return bool -> Retourne FALSE si le chemin remonte au-dessus de la racine
+ */
+static bool ajouterSegment(char *chemin, size_t *longueur, const char *segment, size_t longueurSegment) {
+    // Segment vide (//) ou courant (.) : rien a ajouter
+    if ((longueurSegment == 0) || ((longueurSegment == 1) && (segment[0] == '.'))) {
+        return TRUE;
+    }
+
+    // Segment parent (..) : on retire le dernier segment ajoute
+    if ((longueurSegment == 2) && (segment[0] == '.') && (segment[1] == '.')) {
+        if (*longueur == 0) {
+            return FALSE;
+        }
+
+        while ((*longueur > 0) && (chemin[*longueur - 1] != '/')) {
+            (*longueur)--;
+        }
+        if (*longueur > 0) {
+            (*longueur)--;
+        }
+
+        return TRUE;
+    }
+
+    if (*longueur > 0) {
+        chemin[(*longueur)++] = '/';
+    }
+    memmove(&chemin[*longueur], segment, longueurSegment);
+    *longueur += longueurSegment;
+
+    return TRUE;
+}
+
+int extraitFichier(const Requete *requete, char *nomFichier, size_t maxNomFichier) {
+    const char *debut = requete->cible.debut + 1;
+    size_t longueurCible = 0, longueurDecodee = 0, longueur = 0, debutSegment = 0, i;
+    int fort, faible;
+    bool repertoire;
+
+    // Le nom du fichier s'arrete a la chaine de requete ou au fragment
+    while ((longueurCible < requete->cible.longueur - 1) && (debut[longueurCible] != '?') &&
+           (debut[longueurCible] != '#')) {
+        longueurCible++;
+    }
+
+    // Si la longueur calculee ne rentre pas dans nomFichier, on arrete la recherche
+    if (longueurCible >= maxNomFichier) {
+        return 0;
+    }
+
+    // On decode d'abord la cible : un ".." encode (%2e%2e) sera traite comme les autres
+    for (i = 0; i < longueurCible; i++) {
+        if (debut[i] != '%') {
+            nomFichier[longueurDecodee++] = debut[i];
+            continue;
+        }
+
+        // Un octet nul ou un / encode n'ont pas leur place dans un nom de fichier
+        if ((i + 2 >= longueurCible) || ((fort = valeurHexadecimale(debut[i + 1])) < 0) ||
+            ((faible = valeurHexadecimale(debut[i + 2])) < 0) || ((fort * 16 + faible) == 0) ||
+            ((fort * 16 + faible) == '/')) {
+            return 0;
+        }
+
+        nomFichier[longueurDecodee++] = (char) (fort * 16 + faible);
+        i += 2;
+    }
+
+    repertoire = (longueurDecodee == 0) || (nomFichier[longueurDecodee - 1] == '/');
+
+    // Puis on le normalise sur place, segment par segment : le resultat n'est jamais plus long
+    for (i = 0; i <= longueurDecodee; i++) {
+        if ((i == longueurDecodee) || (nomFichier[i] == '/')) {
+            // Un chemin qui remonte au-dessus de la racine est refuse
+            if (!(ajouterSegment(nomFichier, &longueur, &nomFichier[debutSegment], i - debutSegment))) {
+                return 0;
+            }
+            debutSegment = i + 1;
+        }
+    }
+
+    // Un repertoire designe sa page d'index
+    if ((repertoire) || (longueur == 0)) {
+        if (longueur + strlen("/index.html") >= maxNomFichier) {
+            return 0;
+        }
+        ajouterSegment(nomFichier, &longueur, "index.html", strlen("index.html"));
+    }
+
+    nomFichier[longueur] = '\0';
+
+    return 1;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file    requete.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration de l'analyseur de requetes HTTP/1.1 \n
+ *          L'analyse se fait en place dans le tampon de reception : la
+ *          methode, la cible, la version et les entetes sont decrits par
+ *          des tranches (adresse, longueur) sans aucune allocation.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __REQUETE_H__
+#define __REQUETE_H__
+
+#include "serveur.h"
+
+/* Nombre maximal d'entetes retenus par requete */
+#define MAX_ENTETES 64
+
+/* Valeurs de retour de analyserRequete en dehors d'une requete complete */
+#define ANALYSE_INCOMPLETE 0
+#define ANALYSE_INVALIDE -1
+
+/**
+ * @brief Portion du tampon de reception, non terminee par un zero
+ */
+typedef struct {
+    const char *debut;
+    size_t longueur;
+} Tranche;
+
+/**
+ * @brief Ligne d'entete decoupee en nom et valeur (espaces retires)
+ */
+typedef struct {
+    Tranche nom;
+    Tranche valeur;
+} Entete;
+
+/**
+ * @brief Requete analysee, dont les tranches pointent dans le tampon de reception
+ */
+typedef struct {
+    Tranche methode;
+    Tranche cible;
+    Tranche version;
+    Entete entetes[MAX_ENTETES];
+    size_t nombreEntetes;
+} Requete;
+
+/**
+ * @brief   Analyse une requete en tete du tampon de reception \n
+ *          Note : la recherche de la fin des entetes reprend a la position
+ *          memorisee dans reprise, une requete recue en plusieurs fois n'est
+ *          donc parcourue qu'une fois avant d'etre complete
+ *
+ * @param tampon    Debut des donnees recues non encore traitees
+ * @param taille    Nombre d'octets disponibles
+ * @param requete   Destination de la requete analysee
+ * @param reprise   Position de reprise de la recherche, 0 pour une nouvelle requete
+ * @return          ssize_t -> Retourne le nombre d'octets occupes par la requete si elle est complete,
+ *                  ANALYSE_INCOMPLETE s'il faut plus de donnees, ANALYSE_INVALIDE si elle est mal formee
+ */
+ssize_t analyserRequete(const char *tampon, size_t taille, Requete *requete, size_t *reprise);
+
+/**
+ * @brief Compare une tranche a une chaine, casse comprise
+ *
+ * @param tranche   Tranche a comparer
+ * @param chaine    Chaine terminee par un zero
+ * @return          bool -> Retourne TRUE si elles sont identiques, FALSE sinon
+ */
+bool trancheEgale(const Tranche *tranche, const char *chaine);
+
+/**
+ * @brief Compare une tranche a une chaine sans tenir compte de la casse
+ *
+ * @param tranche   Tranche a comparer
+ * @param chaine    Chaine terminee par un zero
+ * @return          bool -> Retourne TRUE si elles sont identiques, FALSE sinon
+ */
+bool trancheEgaleCasse(const Tranche *tranche, const char *chaine);
+
+/**
+ * @brief Recherche la valeur du premier entete portant un nom donne (casse ignoree)
+ *
+ * @param requete   Requete analysee
+ * @param nom       Nom de l'entete recherche
+ * @return          Tranche* -> Retourne la valeur de l'entete, NULL s'il est absent
+ */
+const Tranche *chercherEntete(const Requete *requete, const char *nom);
+
+/**
+ * @brief   Indique si la connexion doit etre fermee apres la reponse : entete
+ *          Connection contenant close, ou HTTP/1.0 sans keep-alive \n
+ *          Note : en HTTP/1.1 la connexion est persistante par defaut
+ *
+ * @param requete   Requete analysee
+ * @return          bool -> Retourne TRUE si le client ne reutilisera pas la connexion, FALSE sinon
+ */
+bool demandeFermeture(const Requete *requete);
+
+/**
+ * @brief   Indique si la requete annonce un corps (Content-Length non nul ou Transfer-Encoding) \n
+ *          Note : le serveur ne lit pas les corps, la requete suivante ne peut donc pas etre trouvee
+ *
+ * @param requete   Requete analysee
+ * @return          bool -> Retourne TRUE si un corps suit les entetes, FALSE sinon
+ */
+bool porteCorps(const Requete *requete);
+
+/**
+ * @brief Verification que la requete est une requete GET HTTP/1.1 ou HTTP/1.0 sur un chemin absolu
+ *
+ * @param requete   Requete analysee emise par le client
+ * @return          bool -> Retourne TRUE si la requete est supportee, FALSE sinon
+ */
+bool verifierRequete(const Requete *requete);
+
+/**
+ * @brief   Extraction du nom du fichier de la cible de la requete (sans le / initial
+ *          ni la chaine de requete) \n
+ *          Note : le chemin est decode (%XX) et normalise : segments vides et "."
+ *          retires, ".." applique ; un chemin qui remonte au-dessus de la racine
+ *          est refuse, un repertoire designe son index.html
+ *
+ * @param requete       Requete du client verifiee
+ * @param nomFichier    Destination de stockage du nom de fichier
+ * @param maxNomFichier Nombre de caracteres max du nom du fichier
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int extraitFichier(const Requete *requete, char *nomFichier, size_t maxNomFichier);
+
+#endif
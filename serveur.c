@@ -1,665 +1,935 @@
-/**
- * @file    serveur.c
- * @author  Coulais Alexandre
- * @brief   Fichier source des fonctions du serveur \n
- *          Les commentaires de description des fonctions,
- *          avec leurs parametres et valeurs de retour sont dans
- *          le fichier d'entete. \n Ici figurent les commentaires
- *          de description du code des fonctions.
- * @version 1.2
- * @date    2020-12-13
- * 
- * @copyright Copyright (c) 2020
- */
-
-#include "serveur.h"
-
-/* Variables cachees */
-
-/* le socket d'ecoute */
-int socketEcoute;
-/* longueur de l'adresse */
-socklen_t longeurAdr;
-/* le socket de service */
-int socketService;
-/* le tampon de reception */
-char tamponClient[LONGUEUR_TAMPON];
-int debutTampon;
-ssize_t finTampon;
-
-int Initialisation() {
-    return InitialisationAvecService("13214");
-}
-
-int InitialisationAvecService(char *service) {
-    int n;
-    const int on = 1;
-    struct addrinfo hints, *res, *ressave;
-
-    #ifdef WIN32
-    WSADATA wsaData;
-    if (WSAStartup(0x202,&wsaData) == SOCKET_ERROR) {
-        printf("WSAStartup() n'a pas fonctionne, erreur : %d\n", WSAGetLastError()) ;
-        WSACleanup();
-        exit(1);
-    }
-    memset(&hints, 0, sizeof(struct addrinfo));
-    #else
-    bzero(&hints, sizeof(struct addrinfo));
-    #endif
-
-    hints.ai_flags = AI_PASSIVE;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-
-    if ((n = getaddrinfo(NULL, service, &hints, &res)) != 0)  {
-        fprintf(stderr, "Initialisation, erreur de getaddrinfo : %s\n", gai_strerror(n));
-        return 0;
-    }
-
-    ressave = res;
-
-    do {
-        socketEcoute = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-        if (socketEcoute < 0)
-            continue;       /* error, try next one */
-
-        setsockopt(socketEcoute, SOL_SOCKET, SO_REUSEADDR, (const char*) &on, sizeof(on));
-#ifdef BSD
-        setsockopt(socketEcoute, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
-#endif
-        if (bind(socketEcoute, res->ai_addr, res->ai_addrlen) == 0)
-            break;          /* success */
-
-        close(socketEcoute);    /* bind error, close and try next one */
-    } while ((res = res->ai_next) != NULL);
-
-    if (res == NULL) {
-        perror("Initialisation, erreur de bind.");
-        return 0;
-    }
-
-    /* conserve la longueur de l'addresse */
-    longeurAdr = res->ai_addrlen;
-
-    freeaddrinfo(ressave);
-    /* attends au max 4 clients */
-    listen(socketEcoute, 4);
-    printf("Creation du serveur reussie sur %s.\n", service);
-
-    return 1;
-}
-
-int AttenteClient() {
-    struct sockaddr *clientAddr;
-    char machine[NI_MAXHOST];
-
-    clientAddr = (struct sockaddr *) malloc(longeurAdr);
-    socketService = accept(socketEcoute, clientAddr, &longeurAdr);
-
-    if (socketService == -1) {
-        perror("AttenteClient, erreur de accept.");
-        return 0;
-    }
-
-    if (getnameinfo(clientAddr, longeurAdr, machine, NI_MAXHOST, NULL, 0, 0) == 0) {
-        printf("Client sur la machine d'adresse %s connecte.\n", machine);
-    } else {
-        printf("Client anonyme connecte.\n");
-    }
-
-    free(clientAddr);
-    /*
-     * Reinit buffer
-     */
-    debutTampon = 0;
-    finTampon = 0;
-
-    return 1;
-}
-
-char *Reception() {
-    char message[LONGUEUR_TAMPON];
-    int index = 0;
-    int fini = FALSE;
-    ssize_t retour = 0;
-
-    while (!fini) {
-        /* on cherche dans le tampon courant */
-        while ((finTampon > debutTampon) &&
-            (tamponClient[debutTampon] != '\n')) {
-            message[index++] = tamponClient[debutTampon++];
-        }
-        /* on a trouve ? */
-        if ((index > 0) && (tamponClient[debutTampon] == '\n')) {
-            message[index++] = '\n';
-            message[index] = '\0';
-            debutTampon++;
-            fini = TRUE;
-#ifdef WIN32
-            return _strdup(message);
-#else
-            return strdup(message);
-#endif
-        } else {
-            /* il faut en lire plus */
-            debutTampon = 0;
-            retour = recv(socketService, tamponClient, LONGUEUR_TAMPON, 0);
-
-            if (retour < 0) {
-                perror("Reception, erreur de recv.");
-                return NULL;
-            } else if (retour == 0) {
-                fprintf(stderr, "Reception, le client a ferme la connexion.\n");
-                return NULL;
-            } else {
-                /*
-                 * on a recu "retour" octets
-                 */
-                finTampon = retour;
-            }
-        }
-    }
-
-    return NULL;
-}
-
-int Emission(char *message) {
-    size_t taille;
-
-    if (strstr(message, "\n") == NULL) {
-        fprintf(stderr, "Emission, Le message n'est pas termine par \\n.\n");
-        return 0;
-    }
-
-    taille = strlen(message);
-
-    if (send(socketService, message, taille, 0) == -1) {
-        perror("Emission, probleme lors du send.");
-        return 0;
-    }
-
-    return 1;
-}
-
-ssize_t ReceptionBinaire(char *donnees, ssize_t tailleMax) {
-    ssize_t dejaRecu = 0;
-    ssize_t retour = 0;
-    // on commence par recopier tout ce qui reste dans le tampon
-    while ((finTampon > debutTampon) && (dejaRecu < tailleMax)) {
-        donnees[dejaRecu] = tamponClient[debutTampon];
-        dejaRecu++;
-        debutTampon++;
-    }
-    /**
-     * si on n'est pas arrive au max
-     * on essaie de recevoir plus de donnees
-     */
-    if (dejaRecu < tailleMax) {
-        retour = recv(socketService, donnees + dejaRecu, (size_t) (tailleMax - dejaRecu), 0);
-
-        if (retour < 0) {
-            perror("ReceptionBinaire, erreur de recv.");
-            return -1;
-        } else if (retour == 0) {
-            fprintf(stderr, "ReceptionBinaire, le client a ferme la connexion.\n");
-            return 0;
-        } else {
-            // on a recu "retour" octets en plus
-            return dejaRecu + retour;
-        }
-    } else {
-        return dejaRecu;
-    }
-}
-
-ssize_t EmissionBinaire(char *donnees, ssize_t taille) {
-    ssize_t retour = 0;
-    retour = send(socketService, donnees, (size_t) taille, 0);
-
-    if (retour == -1) {
-        perror("Emission, probleme lors du send.");
-        return -1;
-    } else {
-        return retour;
-    }
-}
-
-bool verifierRequete(char *requete) {
-    int match;
-    regex_t preg;
-    const char *str_regex = "^GET \\/\\S* HTTP\\/1\\.1";
-
-    // On fabrique la regex
-    if (regcomp(&preg, str_regex, REG_EXTENDED) != 0) {
-        fprintf(stderr, "Erreur a la construction de l'expression reguliere\n");
-        return FALSE;
-    }
-
-    // On cherche les correspondances dans la chaine de caracteres
-    match = regexec(&preg, requete, 0, NULL, 0);
-    regfree(&preg);
-
-    // Si pas de correspondance on retourne FALSE
-    if (match == REG_NOMATCH) {
-        fprintf(stderr, "%s n'est pas une requete valide\n", requete);
-        return FALSE;
-    }
-
-    return TRUE;
-}
-
-int extraitFichier(char *requete, char *nomFichier, size_t maxNomFichier) {
-    size_t offsetStart = 0;
-    size_t offsetEnd = 0;
-    size_t longueur = 0;
-
-    // Recherche du debut du nom du fichier
-    while (requete[offsetStart] != '/') {
-        offsetStart++;
-    }
-
-    // On ajoute 1 à offsetStart pour se placer sur le premier caractere
-    offsetEnd = ++offsetStart;
-
-    // On recherche la fin du nom du fichier
-    while (requete[offsetEnd] != ' ') {
-        offsetEnd++;
-    }
-
-    longueur = offsetEnd - offsetStart;
-
-    // Si la longueur calculee ne rentre pas dans nomFichier, on arrete la recherche
-    if (longueur >= maxNomFichier) {
-        fprintf(stderr, "Nom fichier demande trop long\n");
-        return 0;
-    }
-
-    // Sinon, on met quelque chose dans nomFichier
-    if (longueur == 0) {
-        // S'il n'y a aucun caractere apres le / on renvoie par defaut index.html
-        strncpy(nomFichier, "index.html", maxNomFichier);
-        nomFichier[strlen("index.html")] = '\0';
-    } else {
-        // Sinon on recopie le nom du fichier
-        strncpy(nomFichier, &requete[offsetStart], longueur);
-        nomFichier[longueur] = '\0';
-    }
-
-    return 1;
-}
-
-int extraitExtension(char *nomFichier, char *extensionFichier, size_t maxExtension) {
-    size_t offsetStart = 0;
-    size_t offsetEnd = strlen(nomFichier);
-    size_t longueur = 0;
-
-    // On recherche le debut de l'extension
-    while (nomFichier[offsetStart] != '.') {
-        offsetStart++;
-    }
-
-    // On incremente offsetStart pour se placer sur le premier caractere de l'extension
-    longueur = offsetEnd - ++offsetStart;
-
-    // Si la longueur calculee depasse la capacite de la destination on arrete la recherche
-    if (longueur >= maxExtension) {
-        fprintf(stderr, "Extension du fichier demande trop longue\n");
-        return 0;
-    }
-
-    // On recopie dans extensionFichier l
-    strncpy(extensionFichier, &nomFichier[offsetStart], longueur);
-    extensionFichier[longueur] = '\0';
-
-    return 1;
-}
-
-bool verifierAccesFichier(char *nomFichier) {
-    // Si le fichier n'existe pas ou qu'il n'est pas lisible on retourne FALSE
-    if (access(nomFichier, F_OK | R_OK) < 0) {
-        fprintf(stderr, "Fichier %s non accessible\n", nomFichier);
-        return FALSE;
-    }
-
-    return TRUE;
-}
-
-ssize_t calculTailleFichier(char *nomFichier) {
-    FILE *file = NULL;
-    ssize_t size = 0;
-
-    // On test l'ouverture du fichier, et on retourne -1 si probleme
-    if ((file = fopen(nomFichier, "rb")) == NULL) {
-        fprintf(stderr, "Erreur lors de la tentative d'ouverture du fichier %s\n", nomFichier);
-        return -1;
-    }
-
-    // On place le curseur a la fin du buffer et on demande sa position
-    fseek(file, 0, SEEK_END);
-    size = ftell(file);
-
-    fclose(file);
-
-    return size;
-}
-
-int envoyerContenuFichierTexte(char *nomFichier) {
-    FILE *file = NULL;
-    char *tampon = NULL;
-    ssize_t tailleFichier;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On ouvre le fichier en controlant les erreurs
-    if ((file = fopen(nomFichier, "rb")) == NULL) {
-        fprintf(stderr, "Erreur a l'ouverture du fichier %s\n", nomFichier);
-        return 0;
-    }
-
-    // On alloue la taille necessaire pour stocker le contenu du fichier en controlant les erreurs
-    if ((tampon = malloc((size_t) (tailleFichier+1) * sizeof(char))) == NULL) {
-        fprintf(stderr, "Erreur d'allocation memoire\n");
-        return 0;
-    }
-
-    // On lit le contenu du fichier en le stockant dans la memoire allouee en verifiant l'absence d'erreur
-    if (fread(tampon, sizeof(char), (size_t) tailleFichier, file) != (size_t) tailleFichier) {
-        fprintf(stderr, "Erreur a la lecture du fichier %s\n", nomFichier);
-        return 0;
-    }
-    
-    tampon[tailleFichier] = '\0';
-
-    // On emet le contenu du fichier en controlant les erreurs
-    if (!(Emission(tampon))) {
-        fprintf(stderr, "Erreur lors de l'emission des donnees\n");
-        return 0;
-    }
-
-    free(tampon);
-    fclose(file);
-
-    return 1;
-}
-
-int envoyerContenuFichierBinaire(char *nomFichier) {
-    FILE *file = NULL;
-    char *tampon = NULL;
-    ssize_t tailleFichier;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On ouvre le fichier en controlant les erreurs
-    if ((file = fopen(nomFichier, "rb")) == NULL) {
-        fprintf(stderr, "Erreur a l'ouverture du fichier %s\n", nomFichier);
-        return 0;
-    }
-
-    // On alloue la taille necessaire pour stocker le contenu du fichier en controlant les erreurs
-    if ((tampon = malloc((size_t) (tailleFichier+1) * sizeof(char))) == NULL) {
-        fprintf(stderr, "Erreur d'allocation memoire\n");
-        return 0;
-    }
-
-    // On lit le contenu du fichier en le stockant dans la memoire allouee en verifiant l'absence d'erreur
-    if (fread(tampon, sizeof(char), (size_t) tailleFichier, file) != (size_t) tailleFichier) {
-        fprintf(stderr, "Erreur a la lecture du fichier %s\n", nomFichier);
-        return 0;
-    }
-
-    tampon[tailleFichier] = '\0';
-
-    // On emet le contenu du fichier en controlant les erreurs
-    if (EmissionBinaire(tampon, tailleFichier+1) == -1) {
-        fprintf(stderr, "Erreur lors de l'emission des donnees\n");
-        return 0;
-    }
-
-    free(tampon);
-    fclose(file);
-
-    return 1;
-}
-
-int envoyerReponse200HTML(char *nomFichier) {
-    char aux[50];
-    ssize_t tailleFichier = 0;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On emet sequentiellement les differentes lignes de la reponse
-    // On s'arrete si une erreur se produit
-    if (!(Emission("HTTP/1.1 200 OK\n"))) {
-        return 0;
-    }
-
-    if (!(Emission(STR_SERVER))) {
-        return 0;
-    }
-
-    if (!(Emission("Content-type: text/html\n"))) {
-        return 0;
-    }
-
-    // On copie dans la chaine auxiliaire la taille du fichier en verifiant une potentielle erreur
-    if (snprintf(aux, 49, "Content-length: %lu\n\n", tailleFichier) < 0) {
-        fprintf(stderr, "Erreur au remplissage de content-length\n");
-        return 0;
-    }
-
-    return Emission(aux);
-}
-
-int envoyerReponse200CSS(char *nomFichier) {
-    char aux[50];
-    ssize_t tailleFichier = 0;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On emet sequentiellement les differentes lignes de la reponse
-    // On s'arrete si une erreur se produit
-    if (!(Emission("HTTP/1.1 200 OK\n"))) {
-        return 0;
-    }
-
-    if (!(Emission(STR_SERVER))) {
-        return 0;
-    }
-
-    if (!(Emission("Content-type: text/css\n"))) {
-        return 0;
-    }
-
-    // On copie dans la chaine auxiliaire la taille du fichier en verifiant une potentielle erreur
-    if (snprintf(aux, 49, "Content-length: %lu\n\n", tailleFichier) < 0) {
-        fprintf(stderr, "Erreur au remplissage de content-length\n");
-        return 0;
-    }
-
-    return Emission(aux);
-}
-
-int envoyerReponse200JS(char *nomFichier) {
-    char aux[50];
-    ssize_t tailleFichier = 0;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On emet sequentiellement les differentes lignes de la reponse
-    // On s'arrete si une erreur se produit
-    if (!(Emission("HTTP/1.1 200 OK\n"))) {
-        return 0;
-    }
-
-    if (!(Emission(STR_SERVER))) {
-        return 0;
-    }
-
-    if (!(Emission("Content-type: application/javascript\n"))) {
-        return 0;
-    }
-
-    // On copie dans la chaine auxiliaire la taille du fichier en verifiant une potentielle erreur
-    if (snprintf(aux, 49, "Content-length: %lu\n\n", tailleFichier) < 0) {
-        fprintf(stderr, "Erreur au remplissage de content-length\n");
-        return 0;
-    }
-
-    return Emission(aux);
-}
-
-int envoyerReponse200JPG(char *nomFichier) {
-    char aux[50];
-    ssize_t tailleFichier = 0;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On emet sequentiellement les differentes lignes de la reponse
-    // On s'arrete si une erreur se produit
-    if (!(Emission("HTTP/1.1 200 OK\n"))) {
-        return 0;
-    }
-
-    if (!(Emission(STR_SERVER))) {
-        return 0;
-    }
-
-    if (!(Emission("Content-type: image/jpeg\n"))) {
-        return 0;
-    }
-
-    // On copie dans la chaine auxiliaire la taille du fichier en verifiant une potentielle erreur
-    if (snprintf(aux, 49, "Content-length: %lu\n\n", tailleFichier) < 0) {
-        fprintf(stderr, "Erreur au remplissage de content-length\n");
-        return 0;
-    }
-
-    return Emission(aux);
-}
-
-int envoyerReponse200ICO(char *nomFichier) {
-    char aux[50];
-    ssize_t tailleFichier = 0;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On emet sequentiellement les differentes lignes de la reponse
-    // On s'arrete si une erreur se produit
-    if (!(Emission("HTTP/1.1 200 OK\n"))) {
-        return 0;
-    }
-
-    if (!(Emission(STR_SERVER))) {
-        return 0;
-    }
-
-    if (!(Emission("Content-type: image/x-icon\n"))) {
-        return 0;
-    }
-
-    // On copie dans la chaine auxiliaire la taille du fichier en verifiant une potentielle erreur
-    if (snprintf(aux, 49, "Content-length: %lu\n\n", tailleFichier) < 0) {
-        fprintf(stderr, "Erreur au remplissage de content-length\n");
-        return 0;
-    }
-
-    return Emission(aux);
-}
-
-int envoyerReponse404HTML(char *nomFichier) {
-    char aux[50];
-    ssize_t tailleFichier = 0;
-
-    // On recupere la taille du fichier en retournant 0 si une erreur se produit
-    if ((tailleFichier = calculTailleFichier(nomFichier)) == -1) {
-        return 0;
-    }
-
-    // On emet sequentiellement les differentes lignes de la reponse
-    // On s'arrete si une erreur se produit
-    if (!(Emission("HTTP/1.1 404 Not Found\n"))) {
-        return 0;
-    }
-
-    if (!(Emission(STR_SERVER))) {
-        return 0;
-    }
-
-    if (!(Emission("Content-type: text/html\n"))) {
-        return 0;
-    }
-
-    // On copie dans la chaine auxiliaire la taille du fichier en verifiant une potentielle erreur
-    if (snprintf(aux, 49, "Content-length: %lu\n\n", tailleFichier) < 0) {
-        fprintf(stderr, "Erreur au remplissage de content-length\n");
-        return 0;
-    }
-
-    return Emission(aux);
-}
-
-int envoyerReponse500(char *message) {
-    char aux[50];
-    size_t tailleMessage = 0;
-
-    // On recupere la longueur de la chaine en retournant 0 si une erreur se produit
-    if ((tailleMessage = strlen(message)) == 0) {
-        return 0;
-    }
-
-    // On emet sequentiellement les differentes lignes de la reponse
-    // On s'arrete si une erreur se produit
-    if (!(Emission("HTTP/1.1 500 Internal Server Error\n"))) {
-        return 0;
-    }
-
-    if (!(Emission(STR_SERVER))) {
-        return 0;
-    }
-
-    if (!(Emission("Content-type: text/html\n"))) {
-        return 0;
-    }
-
-    // On copie dans la chaine auxiliaire la taille du message en verifiant une potentielle erreur
-    if (snprintf(aux, 49, "Content-length: %lu\n\n", tailleMessage) < 0) {
-        fprintf(stderr, "Erreur au remplissage de content-length\n");
-        return 0;
-    }
-
-    if (!(Emission(aux))) {
-        return 0;
-    }
-
-    return Emission(message);
-}
-
-void TerminaisonClient() {
-    close(socketService);
-}
-
-void Terminaison() {
-    close(socketEcoute);
+/**
+ * @file    serveur.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source des fonctions du serveur \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ * 
+ * @copyright Copyright (c) 2020
+ */
+
+#include "serveur.h"
+#include "cache.h"
+#include "erreurs.h"
+#include "mesures.h"
+#include "projection.h"
+#include "racine.h"
+
+/* Admission des clients, fixee au demarrage puis en lecture seule */
+static int backlogEcoute = SOMAXCONN;
+static int maxConnexionsServeur;
+
+/* Connexions ouvertes par tous les travailleurs, comptees seulement si elles sont limitees */
+static int connexionsAdmises;
+
+/* Variables cachees, propres a chaque travailleur */
+
+/* le socket d'ecoute */
+static _Thread_local int socketEcoute;
+/* longueur de l'adresse */
+static _Thread_local socklen_t longeurAdr;
+
+/* Reserves du travailleur : les connexions et leurs tampons y sont pris puis rendus */
+static _Thread_local Pool poolConnexions = POOL_INITIALISEUR(sizeof(Connexion), 64);
+static _Thread_local Pool poolReception = POOL_INITIALISEUR(LONGUEUR_TAMPON, 64);
+static _Thread_local Pool poolSortie = POOL_INITIALISEUR(TAILLE_SORTIE_INITIALE, 64);
+
+void configurerAdmission(int backlog, int maxConnexions) {
+    backlogEcoute = backlog;
+    maxConnexionsServeur = maxConnexions;
+}
+
+bool acceptationASuspendre(int erreur) {
+    return (erreur == EMFILE) || (erreur == ENFILE) || (erreur == ENOBUFS) || (erreur == ENOMEM);
+}
+
+int Initialisation() {
+    return InitialisationAvecService("13214");
+}
+
+int InitialisationAvecService(char *service) {
+    int n;
+    const int on = 1;
+    struct addrinfo hints, *res, *ressave;
+
+    #ifdef WIN32
+    WSADATA wsaData;
+    if (WSAStartup(0x202,&wsaData) == SOCKET_ERROR) {
+        printf("WSAStartup() n'a pas fonctionne, erreur : %d\n", WSAGetLastError()) ;
+        WSACleanup();
+        exit(1);
+    }
+    memset(&hints, 0, sizeof(struct addrinfo));
+    #else
+    bzero(&hints, sizeof(struct addrinfo));
+    #endif
+
+    hints.ai_flags = AI_PASSIVE;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if ((n = getaddrinfo(NULL, service, &hints, &res)) != 0)  {
+        fprintf(stderr, "Initialisation, erreur de getaddrinfo : %s\n", gai_strerror(n));
+        return 0;
+    }
+
+    ressave = res;
+
+    do {
+        socketEcoute = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        if (socketEcoute < 0)
+            continue;       /* error, try next one */
+
+        setsockopt(socketEcoute, SOL_SOCKET, SO_REUSEADDR, (const char*) &on, sizeof(on));
+#ifdef SO_REUSEPORT
+        /* chaque travailleur ouvre son propre socket sur le meme port, le noyau repartit les clients */
+        setsockopt(socketEcoute, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+        if (bind(socketEcoute, res->ai_addr, res->ai_addrlen) == 0)
+            break;          /* success */
+
+        close(socketEcoute);    /* bind error, close and try next one */
+    } while ((res = res->ai_next) != NULL);
+
+    if (res == NULL) {
+        perror("Initialisation, erreur de bind.");
+        return 0;
+    }
+
+    /* conserve la longueur de l'addresse */
+    longeurAdr = res->ai_addrlen;
+
+    freeaddrinfo(ressave);
+
+    /* le reacteur attend les clients sans jamais bloquer sur accept */
+    if (fcntl(socketEcoute, F_SETFL, fcntl(socketEcoute, F_GETFL, 0) | O_NONBLOCK) < 0) {
+        perror("Initialisation, erreur de fcntl.");
+        return 0;
+    }
+
+    /* file d'attente absorbant les rafales, SOMAXCONN par defaut */
+    if (listen(socketEcoute, backlogEcoute) < 0) {
+        perror("Initialisation, erreur de listen.");
+        return 0;
+    }
+    printf("Creation du serveur reussie sur %s.\n", service);
+
+    return 1;
+}
+
+int socketEcouteServeur() {
+    return socketEcoute;
+}
+
+Connexion *AttenteClient() {
+    struct sockaddr_storage clientAddr;
+    socklen_t longueurClient;
+    Connexion *connexion = NULL;
+    int socketService;
+
+    do {
+        longueurClient = sizeof(clientAddr);
+        socketService = accept4(socketEcoute, (struct sockaddr *) &clientAddr, &longueurClient,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (socketService == -1) {
+            // Plus aucun client en attente : ce n'est pas une erreur ; les autres sont comptees
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                compterAcceptationEchouee();
+            }
+            return NULL;
+        }
+
+        connexion = ouvrirConnexion(socketService, (struct sockaddr *) &clientAddr, longueurClient);
+    } while ((connexion == NULL) && (errno == EBUSY));
+
+    return connexion;
+}
+
+/**
+ * @brief Reserve une place parmi les connexions ouvertes du serveur
+ *
+ * @return bool -> Retourne FALSE si la limite est atteinte
+ */
+static bool admettreConnexion(void) {
+    if (maxConnexionsServeur == 0) {
+        return TRUE;
+    }
+
+    // Un seul compteur pour tout le serveur, mais touche seulement a l'ouverture et a la fermeture
+    if (__atomic_fetch_add(&connexionsAdmises, 1, __ATOMIC_RELAXED) >= maxConnexionsServeur) {
+        __atomic_fetch_sub(&connexionsAdmises, 1, __ATOMIC_RELAXED);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Repond 503 a un client refuse et ferme sa connexion, sans jamais attendre
+ */
+static void refuserConnexion(int socketService) {
+    // Refuser un client ne coute qu'un send : la reponse n'est jamais formatee pendant la surcharge
+    const EntreeCache *reponse = reponseErreur(ERREUR_503);
+    char requete[LONGUEUR_TAMPON];
+
+    // La requete deja recue est lue : la fermer non lue ferait envoyer un RST qui effacerait la reponse
+    recv(socketService, requete, sizeof(requete), MSG_DONTWAIT);
+
+    send(socketService, reponse->donnees, reponse->taille, MSG_DONTWAIT | MSG_NOSIGNAL);
+    close(socketService);
+    compterRefus();
+}
+
+Connexion *ouvrirConnexion(int socketService, struct sockaddr *adresse, socklen_t longueurAdresse) {
+    const int on = 1;
+    struct sockaddr_storage clientAddr;
+    socklen_t longueurClient = sizeof(clientAddr);
+    Connexion *connexion = NULL;
+
+    // Au-dela de la limite, le client est prevenu tout de suite plutot que de ralentir les autres
+    if (!(admettreConnexion())) {
+        refuserConnexion(socketService);
+        errno = EBUSY;
+        return NULL;
+    }
+
+    // Sans memoire pour son etat, le client est refuse comme en surcharge
+    if ((connexion = allouerBloc(&poolConnexions)) == NULL) {
+        if (maxConnexionsServeur > 0) {
+            __atomic_fetch_sub(&connexionsAdmises, 1, __ATOMIC_RELAXED);
+        }
+        refuserConnexion(socketService);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    memset(connexion, 0, sizeof(Connexion));
+
+    connexion->socket = socketService;
+    connexion->etat = ETAT_REQUETE;
+    connexion->fichier = -1;
+    initialiserMinuterie(&connexion->minuterie);
+    compterOuverture();
+
+    // Les reponses sont deja regroupees en un seul envoi, Nagle ne ferait que retarder la fin
+    setsockopt(socketService, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    // Sans adresse fournie par l'acceptation, on la demande au noyau
+    if ((adresse == NULL) && (getpeername(socketService, (struct sockaddr *) &clientAddr, &longueurClient) == 0)) {
+        adresse = (struct sockaddr *) &clientAddr;
+        longueurAdresse = longueurClient;
+    }
+
+    // Resolution numerique uniquement : une requete DNS bloquerait tous les autres clients
+    // Rien n'est ecrit par connexion : les ouvertures sont comptees dans les mesures
+    if ((adresse == NULL) || (getnameinfo(adresse, longueurAdresse, connexion->client, sizeof(connexion->client),
+                                          NULL, 0, NI_NUMERICHOST) != 0)) {
+        connexion->client[0] = '\0';
+    }
+
+    return connexion;
+}
+
+int preparerReception(Connexion *connexion) {
+    // Le tampon n'est pris qu'au moment de lire
+    if ((connexion->tamponClient == NULL) && ((connexion->tamponClient = allouerBloc(&poolReception)) == NULL)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    // On ramene les donnees non traitees au debut du tampon pour faire de la place
+    if (connexion->debutTampon > 0) {
+        memmove(connexion->tamponClient, &connexion->tamponClient[connexion->debutTampon],
+                connexion->finTampon - connexion->debutTampon);
+        connexion->finTampon -= connexion->debutTampon;
+        connexion->debutTampon = 0;
+    }
+
+    // Tampon plein sans requete complete : la requete est trop longue pour etre traitee
+    if (connexion->finTampon == LONGUEUR_TAMPON) {
+        errno = ENOBUFS;
+        return 0;
+    }
+
+    return 1;
+}
+
+ssize_t LectureClient(Connexion *connexion) {
+    ssize_t retour = 0;
+
+    if (!(preparerReception(connexion))) {
+        return -1;
+    }
+
+    retour = recv(connexion->socket, &connexion->tamponClient[connexion->finTampon],
+                  LONGUEUR_TAMPON - connexion->finTampon, 0);
+
+    // Une erreur ou une fermeture du client termine seulement sa connexion, sans trace sur stderr
+    if (retour <= 0) {
+        return retour;
+    }
+
+    // on a recu "retour" octets
+    connexion->finTampon += (size_t) retour;
+
+    return retour;
+}
+
+/**
+ * @brief Rend le tampon de sortie a sa reserve, ou au tas s'il a du etre agrandi
+ */
+static void libererSortie(Connexion *connexion) {
+    if (connexion->capaciteSortie == TAILLE_SORTIE_INITIALE) {
+        libererBloc(&poolSortie, connexion->tamponSortie);
+    } else {
+        free(connexion->tamponSortie);
+    }
+
+    connexion->tamponSortie = NULL;
+    connexion->capaciteSortie = 0;
+}
+
+void libererTampons(Connexion *connexion) {
+    if ((connexion->tamponClient != NULL) && (connexion->debutTampon == connexion->finTampon)) {
+        libererBloc(&poolReception, connexion->tamponClient);
+        connexion->tamponClient = NULL;
+        connexion->debutTampon = 0;
+        connexion->finTampon = 0;
+    }
+
+    if ((connexion->tamponSortie != NULL) && (connexion->nombreSegments == 0)) {
+        libererSortie(connexion);
+    }
+}
+
+int Emission(Connexion *connexion, char *message) {
+    // Les echecs sont rendus a l'appelant, sans trace sur stderr
+    if (strstr(message, "\n") == NULL) {
+        return 0;
+    }
+
+    return (EmissionBinaire(connexion, message, (ssize_t) strlen(message)) != -1);
+}
+
+int reserverSortie(Connexion *connexion, size_t taille) {
+    size_t necessaire = connexion->tailleSortie + taille;
+
+    // Les reponses courantes tiennent dans un bloc de la reserve
+    if ((connexion->capaciteSortie == 0) && (necessaire <= TAILLE_SORTIE_INITIALE)) {
+        if ((connexion->tamponSortie = allouerBloc(&poolSortie)) == NULL) {
+            return 0;
+        }
+        connexion->capaciteSortie = TAILLE_SORTIE_INITIALE;
+    }
+
+    // Au-dela, on agrandit la sortie par doublement dans le tas
+    if (necessaire > connexion->capaciteSortie) {
+        size_t capacite = (connexion->capaciteSortie > 0) ? connexion->capaciteSortie : TAILLE_SORTIE_INITIALE;
+        char *tampon = NULL;
+
+        while (capacite < necessaire) {
+            capacite *= 2;
+        }
+
+        if ((tampon = malloc(capacite)) == NULL) {
+            fprintf(stderr, "Erreur d'allocation memoire\n");
+            return 0;
+        }
+
+        if (connexion->tamponSortie != NULL) {
+            memcpy(tampon, connexion->tamponSortie, connexion->tailleSortie);
+            libererSortie(connexion);
+        }
+
+        connexion->tamponSortie = tampon;
+        connexion->capaciteSortie = capacite;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Ajoute a la file les octets qui viennent d'etre ecrits a la fin du tampon de sortie
+ */
+static int enregistrerSortie(Connexion *connexion, size_t taille) {
+    SegmentSortie *dernier = NULL;
+
+    // Des octets contigus du tampon prolongent le dernier segment, jamais une plage de fichier
+    if (connexion->nombreSegments > connexion->premierSegment) {
+        dernier = &connexion->segments[connexion->nombreSegments - 1];
+
+        if ((dernier->entree == NULL) && (!(dernier->fichier)) &&
+            (dernier->debut + dernier->taille == connexion->tailleSortie)) {
+            dernier->taille += taille;
+            connexion->tailleSortie += taille;
+            return 1;
+        }
+    }
+
+    if (connexion->nombreSegments == MAX_SEGMENTS) {
+        fprintf(stderr, "Erreur : file de sortie pleine\n");
+        return 0;
+    }
+
+    connexion->segments[connexion->nombreSegments].entree = NULL;
+    connexion->segments[connexion->nombreSegments].fichier = FALSE;
+    connexion->segments[connexion->nombreSegments].debut = connexion->tailleSortie;
+    connexion->segments[connexion->nombreSegments].taille = taille;
+    connexion->nombreSegments++;
+    connexion->tailleSortie += taille;
+
+    return 1;
+}
+
+ssize_t EmissionBinaire(Connexion *connexion, char *donnees, ssize_t taille) {
+    if (!(reserverSortie(connexion, (size_t) taille))) {
+        return -1;
+    }
+
+    memcpy(&connexion->tamponSortie[connexion->tailleSortie], donnees, (size_t) taille);
+
+    if (!(enregistrerSortie(connexion, (size_t) taille))) {
+        return -1;
+    }
+
+    return taille;
+}
+
+int EmissionEntreeCache(Connexion *connexion, EntreeCache *entree) {
+    return EmissionPlageCache(connexion, entree, 0, entree->taille);
+}
+
+int EmissionPlageCache(Connexion *connexion, EntreeCache *entree, size_t debut, size_t taille) {
+    if (connexion->nombreSegments == MAX_SEGMENTS) {
+        fprintf(stderr, "Erreur : file de sortie pleine\n");
+        return 0;
+    }
+
+    prendreEntreeCache(entree);
+    connexion->segments[connexion->nombreSegments].entree = entree;
+    connexion->segments[connexion->nombreSegments].fichier = FALSE;
+    connexion->segments[connexion->nombreSegments].debut = debut;
+    connexion->segments[connexion->nombreSegments].taille = taille;
+    connexion->nombreSegments++;
+
+    return 1;
+}
+
+int EmissionPlageFichier(Connexion *connexion, off_t debut, off_t taille) {
+    if ((connexion->fichier < 0) && (connexion->projection == NULL)) {
+        fprintf(stderr, "Erreur : aucun fichier ouvert pour la sortie\n");
+        return 0;
+    }
+
+    if (connexion->nombreSegments == MAX_SEGMENTS) {
+        fprintf(stderr, "Erreur : file de sortie pleine\n");
+        return 0;
+    }
+
+    // Une plage vide n'a rien a emettre : sendfile y verrait un fichier tronque
+    if (taille == 0) {
+        return 1;
+    }
+
+    // Une plage isolee n'est pas lue dans l'ordre : on demande ses pages d'avance
+    if ((connexion->projection != NULL) && (taille < (off_t) connexion->projection->taille)) {
+        annoncerLecture(connexion->projection, debut, taille);
+    }
+
+    connexion->segments[connexion->nombreSegments].entree = NULL;
+    connexion->segments[connexion->nombreSegments].fichier = TRUE;
+    connexion->segments[connexion->nombreSegments].debut = (size_t) debut;
+    connexion->segments[connexion->nombreSegments].taille = (size_t) taille;
+    connexion->nombreSegments++;
+
+    return 1;
+}
+
+void commencerReponse(Connexion *connexion) {
+    connexion->segmentsAvantReponse = connexion->nombreSegments;
+    connexion->sortieAvantReponse = connexion->tailleSortie;
+    connexion->statut = 0;
+    connexion->longueurCorps = 0;
+}
+
+bool reponseCommencee(Connexion *connexion) {
+    return (connexion->nombreSegments != connexion->segmentsAvantReponse) ||
+           (connexion->tailleSortie != connexion->sortieAvantReponse);
+}
+
+void abandonnerReponse(Connexion *connexion) {
+    SegmentSortie *dernier = NULL;
+    size_t i;
+
+    for (i = connexion->segmentsAvantReponse; i < connexion->nombreSegments; i++) {
+        if (connexion->segments[i].entree != NULL) {
+            relacherEntreeCache(connexion->segments[i].entree);
+        }
+    }
+    connexion->nombreSegments = connexion->segmentsAvantReponse;
+
+    // Les octets de la reponse ont pu prolonger le dernier segment de la reponse precedente
+    if (connexion->nombreSegments > connexion->premierSegment) {
+        dernier = &connexion->segments[connexion->nombreSegments - 1];
+        if ((dernier->entree == NULL) && (!(dernier->fichier)) &&
+            (dernier->debut + dernier->taille > connexion->sortieAvantReponse)) {
+            dernier->taille = connexion->sortieAvantReponse - dernier->debut;
+        }
+    }
+    connexion->tailleSortie = connexion->sortieAvantReponse;
+
+    // Un fichier ouvert ne peut appartenir qu'a la reponse en cours (voir reponseEnCours)
+    if (connexion->fichier >= 0) {
+        close(connexion->fichier);
+        connexion->fichier = -1;
+    }
+
+    if (connexion->projection != NULL) {
+        relacherProjection(connexion->projection);
+        connexion->projection = NULL;
+    }
+
+    connexion->etat = ETAT_FERMETURE;
+}
+
+bool reponseEnCours(Connexion *connexion) {
+    // La reponse suivante doit trouver la place de tous ses segments dans la file
+    return (connexion->fichier >= 0) || (connexion->projection != NULL) || (connexion->producteur != NULL) ||
+           (connexion->nombreSegments + MAX_SEGMENTS_REPONSE > MAX_SEGMENTS);
+}
+
+/**
+ * @brief Libere les segments deja emis et remet la sortie a zero
+ */
+static void viderSegments(Connexion *connexion) {
+    size_t i;
+
+    for (i = connexion->premierSegment; i < connexion->nombreSegments; i++) {
+        if (connexion->segments[i].entree != NULL) {
+            relacherEntreeCache(connexion->segments[i].entree);
+        }
+    }
+
+    connexion->premierSegment = 0;
+    connexion->nombreSegments = 0;
+    connexion->tailleSortie = 0;
+}
+
+/**
+ * @brief Libere l'etat du producteur d'un corps en flux, termine ou abandonne
+ */
+static void terminerFlux(Connexion *connexion) {
+    if (connexion->liberationFlux != NULL) {
+        connexion->liberationFlux(connexion->contexteFlux);
+    }
+
+    connexion->producteur = NULL;
+    connexion->contexteFlux = NULL;
+    connexion->liberationFlux = NULL;
+}
+
+/**
+ * @brief Ajoute a la sortie le morceau suivant d'un corps en flux, ou le morceau final
+ *
+ * @return int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+static int produireMorceau(Connexion *connexion) {
+    char tailleMorceau[ENTETE_MORCEAU_FLUX + 1];
+    ssize_t produit;
+    size_t debut;
+    int longueurTaille;
+
+    // Le producteur ecrit directement dans la sortie, derriere la place reservee a la taille
+    if (!(reserverSortie(connexion, ENTETE_MORCEAU_FLUX + TAILLE_MORCEAU_FLUX + strlen("\r\n")))) {
+        return 0;
+    }
+
+    debut = connexion->tailleSortie;
+
+    if ((produit = connexion->producteur(connexion->contexteFlux,
+                                         &connexion->tamponSortie[debut + ENTETE_MORCEAU_FLUX],
+                                         TAILLE_MORCEAU_FLUX)) < 0) {
+        fprintf(stderr, "Erreur : production du corps en flux interrompue\n");
+        return 0;
+    }
+
+    if (produit == 0) {
+        terminerFlux(connexion);
+        memcpy(&connexion->tamponSortie[debut], "0\r\n\r\n", strlen("0\r\n\r\n"));
+        return enregistrerSortie(connexion, strlen("0\r\n\r\n"));
+    }
+
+    // La taille est ecrite juste devant les donnees : les octets sautes avant elle ne sont pas emis
+    longueurTaille = snprintf(tailleMorceau, sizeof(tailleMorceau), "%zx\r\n", (size_t) produit);
+    connexion->tailleSortie += (size_t) (ENTETE_MORCEAU_FLUX - longueurTaille);
+    memcpy(&connexion->tamponSortie[connexion->tailleSortie], tailleMorceau, (size_t) longueurTaille);
+    memcpy(&connexion->tamponSortie[debut + ENTETE_MORCEAU_FLUX + (size_t) produit], "\r\n", strlen("\r\n"));
+
+    return enregistrerSortie(connexion, (size_t) longueurTaille + (size_t) produit + strlen("\r\n"));
+}
+
+/**
+ * @brief Emet le debut d'une plage de fichier, directement du cache de pages vers le socket
+ *
+ * @return int -> Retourne 1 si la plage a ete entierement emise, 0 si le socket est plein, -1 en cas d'erreur
+ */
+static int viderPlageFichier(Connexion *connexion, SegmentSortie *segment) {
+    off_t position = (off_t) segment->debut;
+    ssize_t retour;
+
+    while (segment->taille > 0) {
+        retour = sendfile(connexion->socket, connexion->fichier, &position, segment->taille);
+
+        if (retour == -1) {
+            // Client parti ou socket en erreur : la connexion sera fermee
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                return 0;
+            }
+            return -1;
+        } else if (retour == 0) {
+            // Le fichier a raccourci depuis l'envoi de l'entete, on ne peut plus respecter Content-length
+            fprintf(stderr, "viderSortie, fichier tronque pendant l'envoi.\n");
+            return -1;
+        }
+
+        compterOctetsEmis((size_t) retour);
+        segment->debut = (size_t) position;
+        segment->taille -= (size_t) retour;
+    }
+
+    return 1;
+}
+
+int viderSortie(Connexion *connexion) {
+    struct iovec morceaux[MAX_SEGMENTS];
+    struct msghdr message;
+    SegmentSortie *segment = NULL;
+    ssize_t retour = 0;
+    size_t emis, i;
+    int etat;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = morceaux;
+
+    // Toutes les reponses en attente partent ensemble, en un seul appel systeme par plage de fichier
+    while ((connexion->premierSegment < connexion->nombreSegments) || (connexion->producteur != NULL)) {
+        // Le corps en flux n'est produit qu'une fois la sortie videe : il n'en occupe qu'un morceau
+        if (connexion->premierSegment == connexion->nombreSegments) {
+            viderSegments(connexion);
+            if (!(produireMorceau(connexion))) {
+                return -1;
+            }
+            continue;
+        }
+
+        segment = &connexion->segments[connexion->premierSegment];
+
+        if ((segment->fichier) && (connexion->projection == NULL)) {
+            if ((etat = viderPlageFichier(connexion, segment)) <= 0) {
+                return etat;
+            }
+            connexion->premierSegment++;
+            continue;
+        }
+
+        message.msg_iovlen = 0;
+
+        // Les plages d'un fichier projete sont en memoire comme le reste
+        for (i = connexion->premierSegment; (i < connexion->nombreSegments) &&
+             ((!(connexion->segments[i].fichier)) || (connexion->projection != NULL)); i++) {
+            segment = &connexion->segments[i];
+            if (segment->fichier) {
+                morceaux[message.msg_iovlen].iov_base = &connexion->projection->adresse[segment->debut];
+            } else if (segment->entree != NULL) {
+                morceaux[message.msg_iovlen].iov_base = &segment->entree->donnees[segment->debut];
+            } else {
+                morceaux[message.msg_iovlen].iov_base = &connexion->tamponSortie[segment->debut];
+            }
+            morceaux[message.msg_iovlen++].iov_len = segment->taille;
+        }
+
+        // sendmsg plutot que writev pour disposer de MSG_NOSIGNAL, et de MSG_MORE quand une
+        // plage de fichier suit : l'entete part alors dans le meme segment que son debut
+        retour = sendmsg(connexion->socket, &message,
+                         MSG_NOSIGNAL | ((i < connexion->nombreSegments) ? MSG_MORE : 0));
+
+        if (retour == -1) {
+            // Socket plein : le reacteur nous rappellera quand il sera de nouveau inscriptible
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                return 0;
+            }
+            // Client parti ou socket en erreur : la connexion sera fermee
+            return -1;
+        }
+
+        // On repartit les octets emis entre les segments, dans l'ordre
+        emis = (size_t) retour;
+        compterOctetsEmis(emis);
+        while ((emis > 0) && (connexion->premierSegment < i)) {
+            segment = &connexion->segments[connexion->premierSegment];
+
+            if (emis < segment->taille) {
+                segment->debut += emis;
+                segment->taille -= emis;
+                break;
+            }
+
+            emis -= segment->taille;
+            segment->taille = 0;
+
+            if (segment->entree != NULL) {
+                relacherEntreeCache(segment->entree);
+                segment->entree = NULL;
+            }
+            connexion->premierSegment++;
+        }
+    }
+
+    viderSegments(connexion);
+
+    if (connexion->fichier >= 0) {
+        close(connexion->fichier);
+        connexion->fichier = -1;
+    }
+
+    if (connexion->projection != NULL) {
+        relacherProjection(connexion->projection);
+        connexion->projection = NULL;
+    }
+
+    // On ne garde pas un tampon agrandi par une longue rafale de requetes
+    if (connexion->capaciteSortie > TAILLE_SORTIE_INITIALE) {
+        libererSortie(connexion);
+    }
+
+    return 1;
+}
+
+int extraitExtension(char *nomFichier, char *extensionFichier, size_t maxExtension) {
+    char *point = NULL;
+    size_t longueur = 0;
+
+    // L'extension commence apres le dernier point du nom de fichier
+    if (((point = strrchr(nomFichier, '.')) == NULL) || (strchr(point, '/') != NULL)) {
+        return 0;
+    }
+
+    longueur = strlen(++point);
+
+    // Si la longueur calculee depasse la capacite de la destination on arrete la recherche
+    if (longueur >= maxExtension) {
+        return 0;
+    }
+
+    // On recopie dans extensionFichier l'extension trouvee
+    memcpy(extensionFichier, point, longueur);
+    extensionFichier[longueur] = '\0';
+
+    return 1;
+}
+
+bool verifierAccesFichier(char *nomFichier) {
+    struct stat infos;
+
+    // Si le fichier n'existe pas sous la racine ou qu'il n'est pas lisible on retourne FALSE
+    // Rien n'est ecrit sur stderr : une rafale de 404 ne coute qu'un envoi par requete
+    if (resoudreFichier(nomFichier, &infos) < 0) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+int ouvrirFichierSortie(Connexion *connexion, char *nomFichier, off_t *taille) {
+    struct stat infos;
+    int fichier;
+
+    // Un seul fichier peut etre en cours d'envoi par connexion
+    if ((connexion->fichier >= 0) || (connexion->projection != NULL)) {
+        fprintf(stderr, "Erreur : une reponse est deja en cours d'envoi\n");
+        return 0;
+    }
+
+    // Un fichier projete est partage avec les autres reponses qui l'emettent
+    if ((connexion->projection = prendreProjection(nomFichier)) != NULL) {
+        if (taille != NULL) {
+            *taille = (off_t) connexion->projection->taille;
+        }
+        return 1;
+    }
+
+    // Le descripteur du cache est duplique : la connexion peut le garder apres son eviction
+    // Le fichier a pu disparaitre depuis la requete : l'appelant repond sans trace sur stderr
+    if (((fichier = resoudreFichier(nomFichier, &infos)) < 0) ||
+        ((fichier = fcntl(fichier, F_DUPFD_CLOEXEC, 0)) < 0)) {
+        return 0;
+    }
+
+    connexion->fichier = fichier;
+
+    if (taille != NULL) {
+        *taille = infos.st_size;
+    }
+
+    return 1;
+}
+
+int envoyerContenuFichier(Connexion *connexion, char *nomFichier) {
+    off_t taille;
+
+    if (!(ouvrirFichierSortie(connexion, nomFichier, &taille))) {
+        return 0;
+    }
+
+    // Le contenu sera transmis par le noyau (sendfile) au fur et a mesure que le socket l'accepte
+    return EmissionPlageFichier(connexion, 0, taille);
+}
+
+int formaterEntete(char *destination, size_t maxDestination, char *statut, char *typeContenu, long long longueur,
+                   const char *entetes) {
+    int longueurEntete;
+
+    // Toute l'entete est produite en une seule passe de formatage
+    if (longueur < 0) {
+        longueurEntete = snprintf(destination, maxDestination,
+                                  "HTTP/1.1 %s\r\n" STR_SERVER "Content-type: %s\r\nTransfer-Encoding: chunked\r\n%s\r\n",
+                                  statut, typeContenu, entetes);
+    } else {
+        longueurEntete = snprintf(destination, maxDestination,
+                                  "HTTP/1.1 %s\r\n" STR_SERVER "Content-type: %s\r\nContent-length: %lld\r\n%s\r\n",
+                                  statut, typeContenu, longueur, entetes);
+    }
+
+    if ((longueurEntete < 0) || ((size_t) longueurEntete >= maxDestination)) {
+        fprintf(stderr, "Erreur au remplissage de l'entete\n");
+        return -1;
+    }
+
+    return longueurEntete;
+}
+
+int EmissionEntete(Connexion *connexion, char *statut, char *typeContenu, long long longueur, const char *entetes) {
+    int longueurEntete;
+
+    // On reserve la place de l'entete dans la sortie pour la formater directement dedans
+    if (!(reserverSortie(connexion, TAILLE_MAX_ENTETE))) {
+        return 0;
+    }
+
+    if ((longueurEntete = formaterEntete(&connexion->tamponSortie[connexion->tailleSortie], TAILLE_MAX_ENTETE,
+                                         statut, typeContenu, longueur, entetes)) < 0) {
+        return 0;
+    }
+
+    connexion->statut = (int) strtol(statut, NULL, 10);
+    connexion->longueurCorps = longueur;
+
+    return enregistrerSortie(connexion, (size_t) longueurEntete);
+}
+
+int EmissionFlux(Connexion *connexion, char *statut, char *typeContenu, const char *entetes,
+                 ProducteurFlux producteur, void *contexte, LiberationFlux liberation) {
+    connexion->producteur = producteur;
+    connexion->contexteFlux = contexte;
+    connexion->liberationFlux = liberation;
+
+    if (!(EmissionEntete(connexion, statut, typeContenu, -1, entetes))) {
+        terminerFlux(connexion);
+        return 0;
+    }
+
+    // Le premier morceau suit l'entete : une petite reponse part entiere en un seul envoi
+    if (!(produireMorceau(connexion))) {
+        // L'entete est deja en sortie : elle est retiree plutot que suivie d'un corps tronque
+        terminerFlux(connexion);
+        abandonnerReponse(connexion);
+        return 0;
+    }
+
+    return 1;
+}
+
+int EmissionNonModifie(Connexion *connexion, const char *entetes) {
+    int longueurEntete;
+
+    if (!(reserverSortie(connexion, TAILLE_MAX_ENTETE))) {
+        return 0;
+    }
+
+    // Ni Content-type ni Content-length : la reponse 304 n'a pas de corps
+    longueurEntete = snprintf(&connexion->tamponSortie[connexion->tailleSortie], TAILLE_MAX_ENTETE,
+                              "HTTP/1.1 304 Not Modified\r\n" STR_SERVER "%s\r\n", entetes);
+
+    if ((longueurEntete < 0) || (longueurEntete >= TAILLE_MAX_ENTETE)) {
+        fprintf(stderr, "Erreur au remplissage de l'entete\n");
+        return 0;
+    }
+
+    connexion->statut = 304;
+    connexion->longueurCorps = 0;
+
+    return enregistrerSortie(connexion, (size_t) longueurEntete);
+}
+
+int envoyerReponse200(Connexion *connexion, char *typeContenu, off_t taille, const char *entetes) {
+    // La taille vient de la resolution deja faite : le fichier n'est pas resolu une seconde fois
+    return EmissionEntete(connexion, "200 OK", typeContenu, (long long) taille, entetes);
+}
+
+int envoyerReponse416(Connexion *connexion, char *typeContenu, off_t taille, const char *entetes) {
+    char plage[TAILLE_MAX_ENTETE];
+
+    // La taille de la representation permet au client de corriger sa demande
+    if (snprintf(plage, sizeof(plage), "Content-Range: bytes */%lld\r\n%s", (long long) taille, entetes) >=
+        (int) sizeof(plage)) {
+        fprintf(stderr, "Erreur au remplissage de l'entete\n");
+        return 0;
+    }
+
+    return EmissionEntete(connexion, "416 Range Not Satisfiable", typeContenu, 0, plage);
+}
+
+int envoyerReponse500(Connexion *connexion) {
+    // Une reponse ajoutee derriere une entete deja en sortie serait lue comme son corps
+    if (reponseCommencee(connexion)) {
+        abandonnerReponse(connexion);
+        connexion->statut = 500;
+        connexion->longueurCorps = 0;
+        return 1;
+    }
+
+    return envoyerErreur(connexion, ERREUR_500);
+}
+
+void TerminaisonClient(Connexion *connexion) {
+    // La connexion ne doit plus etre visible de la roue de minuteries une fois liberee
+    desarmerMinuterie(&connexion->minuterie);
+    close(connexion->socket);
+    compterFermeture();
+    if (maxConnexionsServeur > 0) {
+        __atomic_fetch_sub(&connexionsAdmises, 1, __ATOMIC_RELAXED);
+    }
+    if (connexion->fichier >= 0) {
+        close(connexion->fichier);
+    }
+    if (connexion->projection != NULL) {
+        relacherProjection(connexion->projection);
+    }
+    if (connexion->producteur != NULL) {
+        terminerFlux(connexion);
+    }
+    viderSegments(connexion);
+    libererTampons(connexion);
+    // Le tampon de reception peut encore contenir une requete incomplete
+    libererBloc(&poolReception, connexion->tamponClient);
+    libererBloc(&poolConnexions, connexion);
+}
+
+void Terminaison() {
+    close(socketEcoute);
 }
\ No newline at end of file
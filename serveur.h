@@ -1,236 +1,509 @@
-/**
- * @file    serveur.h
- * @author  Coulais Alexandre
- * @brief   Fichier de declaration des fonctions du serveur \n
- *          Les commentaires de descriptions du code
- *          sont dans le fichier source. \n Ici figurent les commentaires
- *          de description des fonctions, avec parametres et valeurs de retour
- * @version 1.2
- * @date    2020-12-13
- * 
- * @copyright Copyright (c) 2020
- */
-
-#ifndef __SERVEUR_H__
-#define __SERVEUR_H__
-
-#include <ctype.h>
-#include <errno.h>
-#include <regex.h>
-#include <stdarg.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/types.h>
-
-#ifdef WIN32
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#else
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <netinet/in.h>
-#include <sys/select.h>
-#include <sys/socket.h>
-#include <unistd.h>
-#endif
-
-/* Constantes */
-#define TRUE 1
-#define FALSE 0
-#define LONGUEUR_TAMPON 8192
-
-#define STR_SERVER "Server: Coulais Mortier/1.0.0\n"
-
-#ifdef WIN32
-#define perror(x) printf("%s : code d'erreur : %d\n", (x), WSAGetLastError())
-#define close closesocket
-#define socklen_t int
-#endif
-
-typedef int bool;
-
-/**
- * @brief   Creation du serveur.
- * @return  int -> Retourne 1 si ca c'est bien passe 0 sinon
- */
-int Initialisation(void);
-
-/**
- * @brief Creation du serveur en precisant le service ou numero de port
- * 
- * @param service   Numero de port sur lequel ecouter
- * @return          int -> Retourne 1 si ca c'est bien passe 0 sinon
- */
-int InitialisationAvecService(char *service);
-
-/**
- * @brief Attend qu'un client se connecte
- * 
- * @return int -> Retourne 1 si ca c'est bien passe 0 sinon
- */
-int AttenteClient(void);
-
-/**
- * @brief   Recoit un message envoye par le client \n
- *          Note : penser a liberer la memoire apres traitement
- * 
- * @return char* -> Retourne NULL en cas d'erreur, sinon l'adresse de la chaine
- */
-char *Reception(void);
-
-/**
- * @brief   Envoie un message au client \n
- *          Note : le message doit se terminer par \\n
- * @param message   Chaine de caracteres a envoyer au client
- * @return          int -> Retourne 1 si ca c'est bien passe 0 sinon
- */
-int Emission(char *message);
-
-/**
- * @brief Recoit des donnees envoyees par le client
- * 
- * @param donnees   Destination de stockage des donnees recues
- * @param tailleMax Nombre de caracteres max de donnees
- * @return          ssize_t -> Retourn le nombre d'octets recus, 0 si la connexion est fermee,
- *                  un nombre negatif en cas d'erreur
- */
-ssize_t ReceptionBinaire(char *donnees, ssize_t tailleMax);
-
-/**
- * @brief Envoie des donnees au client en precisant leur taille
- * 
- * @param donnees   Chaine de caracteres a envoyer au client
- * @param taille    Nombre de caracteres contenus dans la chaine donnees
- * @return          ssize_t -> Retourn le nombre d'octets recus, 0 si la connexion est fermee,
- *                  un nombre negatif en cas d'erreur
- */
-ssize_t EmissionBinaire(char *donnees, ssize_t taille);
-
-/**
- * @brief Verification de la constitution de la requete a l'aide d'une regex
- * 
- * @param requete   Requete a verifier emise par le client
- * @return          bool -> Retourne TRUE si la requete est correcte, FALSE sinon
- */
-bool verifierRequete(char *requete);
-
-/**
- * @brief Extraction du nom du fichier de la requete
- * 
- * @param requete       Requete du client verifiee
- * @param nomFichier    Destination de stockage du nom de fichier
- * @param maxNomFichier Nombre de caracteres max du nom du fichier
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int extraitFichier(char *requete, char *nomFichier, size_t maxNomFichier);
-
-/**
- * @brief Extraction de l'extension du nom du fichier
- * 
- * @param nomFichier        Nom du fichier demande par le client
- * @param extensionFichier  Destination de stockage de l'extension
- * @param maxExtension      Nombre de caracteres max de l'extension
- * @return                  int -> Retourne 1 si ce s'est bien passe, 0 sinon
- */
-int extraitExtension(char *nomFichier, char *extension, size_t maxExtension);
-
-/**
- * @brief Verification de l'existence du fichier et son accessibilite
- * 
- * @param nomFichier    Nom du fichier a rechercher
- * @return              bool -> Retourne TRUE si le fichier est accessible, FALSE sinon
- */
-bool verifierAccesFichier(char *nomFichier);
-
-/**
- * @brief Calcul de la taille en octet d'un fichier
- * 
- * @param nomFichier    Nom du fichier dont on veut calculer la taille
- * @return              ssize_t -> Retourne la taille du fichier en octet, -1 si erreur
- */
-ssize_t calculTailleFichier(char *nomFichier);
-
-/**
- * @brief Envoie de donnees en provenance d'un fichier texte
- * 
- * @param nomFichier    Source des donnees a envoyer
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerContenuFichierTexte(char *nomFichier);
-
-/**
- * @brief Envoie de donnees en provenance d'un fichier binaire
- * 
- * @param nomFichier    Source des donnees a envoyer
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerContenuFichierBinaire(char *nomFichier);
-
-/**
- * @brief Envoie d'une reponse HTTP 200 Ok pour un fichier html
- * 
- * @param nomFichier    Nom du fichier contenant les donnees qui vont etre envoyees
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerReponse200HTML(char *nomFichier);
-
-/**
- * @brief Envoie d'une reponse HTTP 200 Ok pour un fichier css
- * 
- * @param nomFichier    Nom du fichier contenant les donnees qui vont etre envoyees
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerReponse200CSS(char *nomFichier);
-
-/**
- * @brief Envoie d'une reponse HTTP 200 Ok pour un fichier javascript
- * 
- * @param nomFichier    Nom du fichier contenant les donnees qui vont etre envoyees
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerReponse200JS(char *nomFichier);
-
-/**
- * @brief Envoie d'une reponse HTTP 200 Ok pour un fichier jpg/jpeg
- * 
- * @param nomFichier    Nom du fichier contenant les donnees qui vont etre envoyees
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerReponse200JPG(char *nomFichier);
-
-/**
- * @brief Envoie d'une reponse HTTP 200 Ok pour un fichier ico
- * 
- * @param nomFichier    Nom du fichier contenant les donnees qui vont etre envoyees
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerReponse200ICO(char *nomFichier);
-
-/**
- * @brief Envoie d'une reponse HTTP 404 Not Found
- * 
- * @param nomFichier    Nom du fichier html contenant la page 404
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerReponse404HTML(char *nomFichier);
-
-/**
- * @brief Envoie d'une reponse HTTP 500 Internal Server Error
- * 
- * @param nomFichier    Message a envoyer au client
- * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
- */
-int envoyerReponse500(char *message);
-
-/**
- * @brief Fermeture de la connexion avec le client
- */
-void TerminaisonClient(void);
-
-/**
- * @brief Fermeture du serveur
- */
-void Terminaison(void);
-
-#endif
+/**
+ * @file    serveur.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration des fonctions du serveur \n
+ *          Les commentaires de descriptions du code
+ *          sont dans le fichier source. \n Ici figurent les commentaires
+ *          de description des fonctions, avec parametres et valeurs de retour
+ * @version 1.2
+ * @date    2020-12-13
+ * 
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __SERVEUR_H__
+#define __SERVEUR_H__
+
+/* accept4, sendfile et consorts sont des extensions Linux */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "minuterie.h"
+#include "pool.h"
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/* Constantes */
+#define TRUE 1
+#define FALSE 0
+#define LONGUEUR_TAMPON 8192
+#define TAILLE_SORTIE_INITIALE 4096
+#define TAILLE_MAX_ENTETE 512
+#define MAX_SEGMENTS 64
+/* Segments ajoutes au plus par une reponse : entete, puis une plage de corps et son
+   separateur par partie d'une reponse multipart/byteranges */
+#define MAX_SEGMENTS_REPONSE 17
+/* Octets produits au plus par appel du producteur d'un corps en flux, soit un morceau chunked */
+#define TAILLE_MORCEAU_FLUX 16384
+/* Place reservee devant chaque morceau pour sa taille en hexadecimal et sa fin de ligne */
+#define ENTETE_MORCEAU_FLUX 8
+
+/* Delai annonce par Retry-After aux clients refuses en surcharge, en secondes */
+#define DELAI_REESSAI_SURCHARGE 1
+/* Duree de la pause des acceptations quand les descripteurs ou la memoire manquent, en millisecondes */
+#define PAUSE_ACCEPTATION_MS 100
+
+#define STR_SERVER "Server: Coulais Mortier/1.0.0\r\n"
+
+#ifdef WIN32
+#define perror(x) printf("%s : code d'erreur : %d\n", (x), WSAGetLastError())
+#define close closesocket
+#define socklen_t int
+#endif
+
+typedef int bool;
+
+/**
+ * @brief Etats successifs d'une connexion client
+ */
+typedef enum {
+    ETAT_REQUETE,           /* attente ou traitement des requetes du client */
+    ETAT_FERMETURE          /* la connexion doit etre fermee une fois la sortie videe */
+} EtatConnexion;
+
+/**
+ * @brief Delai dont la minuterie d'une connexion surveille l'echeance
+ */
+typedef enum {
+    ECHEANCE_AUCUNE,        /* requete terminee : le prochain delai repart de zero */
+    ECHEANCE_ENTETES,       /* requete commencee (ou premiere attendue), non prolongee par les octets recus */
+    ECHEANCE_INACTIVITE,    /* attente de la requete suivante sur une connexion persistante */
+    ECHEANCE_EMISSION,      /* sortie bloquee par un socket plein, prolongee a chaque progression */
+    NOMBRE_ECHEANCES
+} EcheanceConnexion;
+
+/**
+ * @brief   Fonction qui produit la suite d'un corps en flux, appelee chaque fois que la
+ *          sortie precedente est emise \n
+ *          Note : elle ne doit pas bloquer, le corps est produit au rythme ou le client le lit
+ *
+ * @param contexte      Etat du producteur, fourni a EmissionFlux
+ * @param destination   Tampon recevant la suite du corps
+ * @param capacite      Nombre d'octets disponibles, au moins TAILLE_MORCEAU_FLUX
+ * @return              ssize_t -> Retourne le nombre d'octets produits, 0 a la fin du corps,
+ *                      un nombre negatif en cas d'erreur
+ */
+typedef ssize_t (*ProducteurFlux)(void *contexte, char *destination, size_t capacite);
+
+/**
+ * @brief Fonction qui libere l'etat d'un producteur, une fois le corps termine ou abandonne
+ */
+typedef void (*LiberationFlux)(void *contexte);
+
+/* Reponse du cache en cours d'emission (voir cache.h) */
+struct EntreeCache;
+/* Fichier projete en cours d'emission (voir projection.h) */
+struct Projection;
+
+/**
+ * @brief Morceau de la sortie : octets du tampon de sortie, d'une reponse du cache
+ *        ou du fichier de la connexion, emis dans l'ordre d'ajout
+ */
+typedef struct {
+    struct EntreeCache *entree; /* reponse du cache, NULL pour des octets du tampon de sortie */
+    bool fichier;               /* plage du fichier de la connexion : sendfile ou sa projection */
+    size_t debut;               /* position du reste a emettre dans le tampon, l'entree ou le fichier */
+    size_t taille;              /* nombre d'octets restant a emettre */
+} SegmentSortie;
+
+/**
+ * @brief   Etat propre a chaque client connecte : socket, tampon de reception
+ *          et tampon des donnees restant a emettre \n
+ *          Note : les deux tampons sont pris dans les reserves du travailleur
+ *          et n'existent que le temps d'une rafale de requetes, une connexion
+ *          inactive n'en garde aucun
+ */
+typedef struct {
+    int socket;
+    EtatConnexion etat;
+    bool lisible;           /* le socket peut contenir des donnees non encore lues */
+    char *tamponClient;     /* LONGUEUR_TAMPON octets, NULL si rien n'est en attente */
+    size_t debutTampon;
+    size_t finTampon;
+    size_t repriseAnalyse;  /* position de reprise de l'analyse de la requete en cours */
+    char *tamponSortie;     /* arene des reponses en cours, remise a zero une fois emise */
+    size_t tailleSortie;
+    size_t capaciteSortie;
+    SegmentSortie segments[MAX_SEGMENTS];   /* reponses en attente, emises ensemble */
+    size_t premierSegment;
+    size_t nombreSegments;
+    int fichier;            /* fichier dont des plages sont en cours d'envoi, -1 si aucun */
+    struct Projection *projection;  /* ou sa projection en memoire, NULL si aucune */
+    ProducteurFlux producteur;      /* corps en flux en cours de production, NULL si aucun */
+    void *contexteFlux;
+    LiberationFlux liberationFlux;
+    size_t segmentsAvantReponse;    /* etat de la sortie avant la reponse en cours, */
+    size_t sortieAvantReponse;      /* pour pouvoir l'abandonner */
+    int statut;             /* code de la derniere reponse ajoutee a la sortie, pour les mesures */
+    long long longueurCorps;    /* et longueur de son corps, pour le journal, -1 si en flux */
+    char client[INET6_ADDRSTRLEN];  /* adresse numerique du client, vide si inconnue */
+    Minuterie minuterie;    /* echeance du delai surveille, geree par le reacteur */
+    EcheanceConnexion echeance; /* delai surveille par la minuterie */
+    int nonAcquittes;       /* octets emis non acquittes par le client, mesures a l'armement du delai d'emission */
+    bool operationEnCours;  /* une operation io_uring designe encore la connexion */
+    bool annulee;           /* fermeture attendant la fin de cette operation */
+} Connexion;
+
+/**
+ * @brief   Fixe la file d'attente du socket d'ecoute et le nombre maximal de connexions 
+
+ *          Note : a appeler avant le demarrage des travailleurs ; au-dela de la limite, les
+ *          clients recoivent aussitot une reponse 503 preparee d'avance puis sont deconnectes
+ *
+ * @param backlog           Longueur de la file d'attente passee a listen
+ * @param maxConnexions     Connexions ouvertes au plus par tout le serveur, 0 pour aucune limite
+ */
+void configurerAdmission(int backlog, int maxConnexions);
+
+/**
+ * @brief Indique si une erreur d'acceptation vient d'un manque de descripteurs ou de memoire
+ *
+ * @param erreur    Code d'erreur (errno) de l'acceptation
+ * @return          bool -> Retourne TRUE si les acceptations doivent etre suspendues un moment
+ */
+bool acceptationASuspendre(int erreur);
+
+/**
+ * @brief   Creation du serveur.
+ * @return  int -> Retourne 1 si ca c'est bien passe 0 sinon
+ */
+int Initialisation(void);
+
+/**
+ * @brief Creation du serveur en precisant le service ou numero de port
+ * 
+ * @param service   Numero de port sur lequel ecouter
+ * @return          int -> Retourne 1 si ca c'est bien passe 0 sinon
+ */
+int InitialisationAvecService(char *service);
+
+/**
+ * @brief Renvoie le socket d'ecoute cree par l'initialisation
+ * 
+ * @return int -> Descripteur du socket d'ecoute
+ */
+int socketEcouteServeur(void);
+
+/**
+ * @brief   Accepte un client en attente sur le socket d'ecoute (non bloquant) \n
+ *          Note : penser a liberer la connexion avec TerminaisonClient ; les clients
+ *          refuses en surcharge sont passes pour accepter les suivants
+ * 
+ * @return Connexion* -> Retourne la nouvelle connexion, NULL si aucun client n'attend ou erreur
+ *         (errno vaut EAGAIN s'il n'y a plus de client)
+ */
+Connexion *AttenteClient(void);
+
+/**
+ * @brief   Cree l'etat d'un client dont la connexion vient d'etre acceptee \n
+ *          Note : le socket doit deja etre non bloquant ; en cas d'echec, le client recoit
+ *          une reponse 503 et son socket est ferme
+ * 
+ * @param socketService     Socket de la connexion acceptee
+ * @param adresse           Adresse du client, NULL pour la demander au noyau
+ * @param longueurAdresse   Longueur de l'adresse
+ * @return                  Connexion* -> Retourne la connexion, NULL en cas d'erreur (errno vaut
+ *                          EBUSY si le client a ete refuse en surcharge, ENOMEM si la memoire manque)
+ */
+Connexion *ouvrirConnexion(int socketService, struct sockaddr *adresse, socklen_t longueurAdresse);
+
+/**
+ * @brief   Prepare le tampon de reception a accueillir de nouvelles donnees : le prend
+ *          dans la reserve si besoin et ramene les donnees non traitees au debut
+ * 
+ * @param connexion Connexion du client
+ * @return          int -> Retourne 1 si de la place est disponible, 0 sinon (errno vaut
+ *                  ENOBUFS si le tampon est plein sans requete complete)
+ */
+int preparerReception(Connexion *connexion);
+
+/**
+ * @brief Lit sans bloquer tout ce que le client a envoye dans le tampon de la connexion
+ * 
+ * @param connexion Connexion du client
+ * @return          ssize_t -> Retourne le nombre d'octets lus, 0 si la connexion est fermee,
+ *                  un nombre negatif en cas d'erreur
+ */
+ssize_t LectureClient(Connexion *connexion);
+
+/**
+ * @brief   Rend aux reserves les tampons dont la connexion n'a plus besoin : tampon de
+ *          reception vide et sortie entierement emise \n
+ *          Note : a appeler quand la connexion attend son prochain evenement
+ * 
+ * @param connexion Connexion du client
+ */
+void libererTampons(Connexion *connexion);
+
+/**
+ * @brief   Ajoute un message a la sortie du client \n
+ *          Note : le message doit se terminer par \\n
+ * @param connexion Connexion du client
+ * @param message   Chaine de caracteres a envoyer au client
+ * @return          int -> Retourne 1 si ca c'est bien passe 0 sinon
+ */
+int Emission(Connexion *connexion, char *message);
+
+/**
+ * @brief Garantit que la sortie du client peut recevoir taille octets supplementaires
+ * 
+ * @param connexion Connexion du client
+ * @param taille    Nombre d'octets a pouvoir ajouter
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int reserverSortie(Connexion *connexion, size_t taille);
+
+/**
+ * @brief Ajoute des donnees a la sortie du client en precisant leur taille
+ * 
+ * @param connexion Connexion du client
+ * @param donnees   Chaine de caracteres a envoyer au client
+ * @param taille    Nombre de caracteres contenus dans la chaine donnees
+ * @return          ssize_t -> Retourne le nombre d'octets ajoutes, un nombre negatif en cas d'erreur
+ */
+ssize_t EmissionBinaire(Connexion *connexion, char *donnees, ssize_t taille);
+
+/**
+ * @brief   Note l'etat de la sortie avant la reponse a une nouvelle requete \n
+ *          Note : a appeler avant le traitement de chaque requete
+ * 
+ * @param connexion Connexion du client
+ */
+void commencerReponse(Connexion *connexion);
+
+/**
+ * @brief Indique si une partie de la reponse en cours est deja dans la sortie
+ * 
+ * @param connexion Connexion du client
+ * @return          bool -> Retourne TRUE si une reponse a ete commencee, FALSE sinon
+ */
+bool reponseCommencee(Connexion *connexion);
+
+/**
+ * @brief   Retire de la sortie la partie deja ajoutee de la reponse en cours et ferme son
+ *          fichier \n
+ *          Note : les reponses precedentes restent entieres ; la connexion est fermee une
+ *          fois la sortie videe, aucune autre reponse ne doit suivre
+ * 
+ * @param connexion Connexion du client
+ */
+void abandonnerReponse(Connexion *connexion);
+
+/**
+ * @brief   Indique si la sortie ne peut plus accueillir de reponse : un fichier ou un corps
+ *          en flux est en cours d'envoi, ou la file des segments est pleine \n
+ *          Note : les requetes suivantes ne doivent pas etre traitees avant qu'elle soit videe
+ * 
+ * @param connexion Connexion du client
+ * @return          bool -> Retourne TRUE si la sortie doit etre videe d'abord, FALSE sinon
+ */
+bool reponseEnCours(Connexion *connexion);
+
+/**
+ * @brief Ajoute une reponse du cache a la file de sortie, sans copie
+ * 
+ * @param connexion Connexion du client
+ * @param entree    Reponse du cache, referencee jusqu'a son emission
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 si la file est pleine
+ */
+int EmissionEntreeCache(Connexion *connexion, struct EntreeCache *entree);
+
+/**
+ * @brief Ajoute une partie d'une reponse du cache a la file de sortie, sans copie
+ * 
+ * @param connexion Connexion du client
+ * @param entree    Reponse du cache, referencee jusqu'a son emission
+ * @param debut     Position de la partie dans les donnees de l'entree
+ * @param taille    Nombre d'octets de la partie
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 si la file est pleine
+ */
+int EmissionPlageCache(Connexion *connexion, struct EntreeCache *entree, size_t debut, size_t taille);
+
+/**
+ * @brief   Ajoute une plage du fichier ouvert par ouvrirFichierSortie a la file de sortie 
+
+ *          Note : la plage est transmise sans copie par sendfile lorsque le socket est pret
+ * 
+ * @param connexion Connexion du client
+ * @param debut     Position du premier octet dans le fichier
+ * @param taille    Nombre d'octets de la plage
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int EmissionPlageFichier(Connexion *connexion, off_t debut, off_t taille);
+
+/**
+ * @brief   Ajoute l'entete d'une reponse dont le corps est produit au fur et a mesure de
+ *          son emission, en Transfer-Encoding: chunked, ainsi que son premier morceau \n
+ *          Note : un seul morceau attend dans la sortie a la fois ; le suivant n'est
+ *          produit qu'une fois le precedent emis, quand le socket l'a accepte
+ * 
+ * @param connexion     Connexion du client
+ * @param statut        Code et message du statut, par exemple "200 OK"
+ * @param typeContenu   Type MIME du corps
+ * @param entetes       Lignes d'entete supplementaires terminees par \r\n, "" si aucune
+ * @param producteur    Fonction qui produit le corps
+ * @param contexte      Etat du producteur, libere par liberation dans tous les cas
+ * @param liberation    Fonction qui libere contexte, NULL si rien a liberer
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon (si l'entete est deja
+ *                      en sortie, la connexion sera fermee une fois la sortie videe)
+ */
+int EmissionFlux(Connexion *connexion, char *statut, char *typeContenu, const char *entetes,
+                 ProducteurFlux producteur, void *contexte, LiberationFlux liberation);
+
+/**
+ * @brief Emet sans bloquer tous les segments en attente dans la sortie du client, les
+ *        octets en memoire en un seul appel jusqu'a chaque plage de fichier, puis les
+ *        morceaux d'un corps en flux a mesure qu'ils sont produits
+ * 
+ * @param connexion Connexion du client
+ * @return          int -> Retourne 1 si tout a ete emis, 0 si le socket est plein, -1 en cas d'erreur
+ */
+int viderSortie(Connexion *connexion);
+
+/**
+ * @brief Extraction de l'extension du nom du fichier
+ * 
+ * @param nomFichier        Nom du fichier demande par le client
+ * @param extensionFichier  Destination de stockage de l'extension
+ * @param maxExtension      Nombre de caracteres max de l'extension
+ * @return                  int -> Retourne 1 si ce s'est bien passe, 0 sinon
+ */
+int extraitExtension(char *nomFichier, char *extension, size_t maxExtension);
+
+/**
+ * @brief Verification de l'existence du fichier et son accessibilite
+ * 
+ * @param nomFichier    Nom du fichier a rechercher
+ * @return              bool -> Retourne TRUE si le fichier est accessible, FALSE sinon
+ */
+bool verifierAccesFichier(char *nomFichier);
+
+/**
+ * @brief   Ouvre le fichier dont des plages vont etre ajoutees a la sortie du client \n
+ *          Note : il est ferme une fois la sortie videe ; en mode projection, c'est la
+ *          projection partagee du fichier qui est prise, puis rendue
+ * 
+ * @param connexion     Connexion du client
+ * @param nomFichier    Source des donnees a envoyer
+ * @param taille        Destination de la taille du fichier, NULL si inutile
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int ouvrirFichierSortie(Connexion *connexion, char *nomFichier, off_t *taille);
+
+/**
+ * @brief   Programme l'envoi du contenu d'un fichier apres les donnees deja en sortie \n
+ *          Note : le contenu est transmis sans copie par sendfile lorsque le socket est pret
+ * 
+ * @param connexion     Connexion du client
+ * @param nomFichier    Source des donnees a envoyer
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerContenuFichier(Connexion *connexion, char *nomFichier);
+
+/**
+ * @brief Formate la ligne de statut et toutes les lignes d'entete d'une reponse
+ * 
+ * @param destination       Tampon recevant l'entete
+ * @param maxDestination    Taille du tampon
+ * @param statut            Code et message du statut, par exemple "200 OK"
+ * @param typeContenu       Type MIME du corps
+ * @param longueur          Longueur du corps en octets, negative pour un corps en flux
+ *                          (Transfer-Encoding: chunked)
+ * @param entetes           Lignes d'entete supplementaires terminees par \r\n, "" si aucune
+ * @return                  int -> Retourne la longueur de l'entete, -1 si elle ne rentre pas
+ */
+int formaterEntete(char *destination, size_t maxDestination, char *statut, char *typeContenu, long long longueur,
+                   const char *entetes);
+
+/**
+ * @brief Ajoute en une fois l'entete complete d'une reponse a la sortie du client
+ * 
+ * @param connexion     Connexion du client
+ * @param statut        Code et message du statut, par exemple "200 OK"
+ * @param typeContenu   Type MIME du corps
+ * @param longueur      Longueur du corps en octets, negative pour un corps en flux
+ * @param entetes       Lignes d'entete supplementaires terminees par \r\n, "" si aucune
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int EmissionEntete(Connexion *connexion, char *statut, char *typeContenu, long long longueur, const char *entetes);
+
+/**
+ * @brief Ajoute a la sortie du client une reponse 304 Not Modified, sans corps
+ * 
+ * @param connexion     Connexion du client
+ * @param entetes       Lignes d'entete (validateurs, Vary) terminees par \r\n
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int EmissionNonModifie(Connexion *connexion, const char *entetes);
+
+/**
+ * @brief Envoie d'une reponse HTTP 200 Ok pour un fichier de type quelconque
+ * 
+ * @param connexion     Connexion du client
+ * @param typeContenu   Type MIME du fichier
+ * @param taille        Taille du fichier, connue depuis sa resolution
+ * @param entetes       Lignes d'entete supplementaires terminees par \r\n, "" si aucune
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerReponse200(Connexion *connexion, char *typeContenu, off_t taille, const char *entetes);
+
+/**
+ * @brief Envoie d'une reponse HTTP 416 Range Not Satisfiable, sans corps
+ * 
+ * @param connexion     Connexion du client
+ * @param typeContenu   Type MIME de la representation
+ * @param taille        Taille de la representation, annoncee dans Content-Range
+ * @param entetes       Lignes d'entete supplementaires terminees par \r\n, "" si aucune
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerReponse416(Connexion *connexion, char *typeContenu, off_t taille, const char *entetes);
+
+/**
+ * @brief   Envoie de la reponse HTTP 500 Internal Server Error preparee \n
+ *          Note : si la reponse est deja commencee, elle est abandonnee et la connexion fermee
+ * 
+ * @param connexion     Connexion du client
+ * @return              int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerReponse500(Connexion *connexion);
+
+/**
+ * @brief Fermeture de la connexion avec le client et liberation de son etat
+ * 
+ * @param connexion Connexion du client
+ */
+void TerminaisonClient(Connexion *connexion);
+
+/**
+ * @brief Fermeture du serveur
+ */
+void Terminaison(void);
+
+#endif
@@ -0,0 +1,379 @@
+/**
+ * @file    trace.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source du tracage des phases du traitement \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "mesures.h"
+#include "trace.h"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Duree de chaque phase d'une requete, en nanosecondes
+ */
+typedef struct {
+    uint64_t duree;
+    uint64_t phases[NOMBRE_PHASES];
+    char cible[LONGUEUR_MAX_CIBLE_TRACE];
+} TraceRequete;
+
+/**
+ * @brief   Traces d'un travailleur, ecrites par lui seul \n
+ *          Note : les requetes lentes sont protegees par un compteur de sequence,
+ *          impair pendant leur mise a jour, que le lecteur verifie avant et apres
+ */
+typedef struct {
+    _Alignas(TAILLE_LIGNE_CACHE) uint64_t intervalles[NOMBRE_PHASES + 1][NOMBRE_INTERVALLES_LATENCE];
+    uint64_t sequence;
+    TraceRequete lentes[NOMBRE_TRACES_LENTES];
+} Traces;
+
+/* Noms des phases, dans l'ordre de PhaseTrace, puis la duree totale */
+static const char *nomsPhases[NOMBRE_PHASES + 1] = {
+    "analyse", "verification", "cache", "resolution", "preparation", "emission", "total"
+};
+
+/* Nanosecondes par cycle du compteur, fixe au demarrage */
+static double nanosecondesParCycle = 1.0;
+
+/* Traces de tous les travailleurs inscrits, lues par /__trace */
+static Traces *tracesTravailleurs[MAX_TRAVAILLEURS_MESURES];
+static int nombreInscrits;
+
+/* Traces du travailleur courant et requete en cours de tracage */
+static _Thread_local Traces tracesLocales;
+static _Thread_local TraceRequete traceCourante;
+static _Thread_local uint64_t debutCourant;
+static _Thread_local uint64_t derniereMarque;
+static _Thread_local bool traceOuverte;
+/* Indice de la moins lente des requetes lentes gardees */
+static _Thread_local size_t moinsLente;
+
+/**
+ * @brief Instant courant en cycles : rdtsc quand il existe, horloge monotone sinon
+ */
+static uint64_t instantCycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec maintenant;
+
+    clock_gettime(CLOCK_MONOTONIC, &maintenant);
+
+    return (uint64_t) maintenant.tv_sec * 1000000000 + (uint64_t) maintenant.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Instant de l'horloge monotone en nanosecondes
+ */
+static uint64_t instantNs(void) {
+    struct timespec maintenant;
+
+    clock_gettime(CLOCK_MONOTONIC, &maintenant);
+
+    return (uint64_t) maintenant.tv_sec * 1000000000 + (uint64_t) maintenant.tv_nsec;
+}
+
+void initialiserTrace(void) {
+    const struct timespec pause = { 0, 20000000 };
+    uint64_t debutNs, debutCycles;
+
+    // La frequence du compteur se deduit de son avance pendant une pause de 20 ms
+    debutNs = instantNs();
+    debutCycles = instantCycles();
+    nanosleep(&pause, NULL);
+    nanosecondesParCycle = (double) (instantNs() - debutNs) / (double) (instantCycles() - debutCycles);
+
+    printf("Tracage des phases actif, %.3f ns par cycle.\n", nanosecondesParCycle);
+}
+
+void inscrireTraces(void) {
+    int indice = __atomic_fetch_add(&nombreInscrits, 1, __ATOMIC_RELAXED);
+
+    if (indice >= MAX_TRAVAILLEURS_MESURES) {
+        fprintf(stderr, "inscrireTraces, trop de travailleurs\n");
+        return;
+    }
+
+    __atomic_store_n(&tracesTravailleurs[indice], &tracesLocales, __ATOMIC_RELEASE);
+}
+
+void debuterTrace(void) {
+    // Requete suivante d'une rafale : la precedente n'a pas d'emission propre
+    if (traceOuverte) {
+        terminerTrace();
+    }
+
+    debutCourant = instantCycles();
+    derniereMarque = debutCourant;
+}
+
+void ouvrirTrace(const Requete *requete) {
+    size_t longueur = (requete->cible.longueur < LONGUEUR_MAX_CIBLE_TRACE) ? requete->cible.longueur
+                                                                           : LONGUEUR_MAX_CIBLE_TRACE - 1;
+
+    memset(traceCourante.phases, 0, sizeof(traceCourante.phases));
+    memcpy(traceCourante.cible, requete->cible.debut, longueur);
+    traceCourante.cible[longueur] = '\0';
+    traceOuverte = TRUE;
+
+    marquerPhase(PHASE_ANALYSE);
+}
+
+void marquerPhase(PhaseTrace phase) {
+    uint64_t maintenant;
+
+    if (!(traceOuverte)) {
+        return;
+    }
+
+    // Les cycles ne sont convertis qu'a la fin de la trace
+    maintenant = instantCycles();
+    traceCourante.phases[phase] += maintenant - derniereMarque;
+    derniereMarque = maintenant;
+}
+
+/**
+ * @brief Garde la trace si elle fait partie des plus lentes du travailleur
+ */
+static void garderSiLente(void) {
+    size_t i;
+
+    if (traceCourante.duree <= tracesLocales.lentes[moinsLente].duree) {
+        return;
+    }
+
+    __atomic_store_n(&tracesLocales.sequence, tracesLocales.sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    tracesLocales.lentes[moinsLente] = traceCourante;
+    __atomic_store_n(&tracesLocales.sequence, tracesLocales.sequence + 1, __ATOMIC_RELEASE);
+
+    for (i = 0; i < NOMBRE_TRACES_LENTES; i++) {
+        if (tracesLocales.lentes[i].duree < tracesLocales.lentes[moinsLente].duree) {
+            moinsLente = i;
+        }
+    }
+}
+
+void terminerTrace(void) {
+    uint64_t *intervalle = NULL;
+    size_t phase;
+
+    if (!(traceOuverte)) {
+        return;
+    }
+
+    marquerPhase(PHASE_EMISSION);
+    traceOuverte = FALSE;
+
+    for (phase = 0; phase < NOMBRE_PHASES; phase++) {
+        traceCourante.phases[phase] = (uint64_t) ((double) traceCourante.phases[phase] * nanosecondesParCycle);
+        intervalle = &tracesLocales.intervalles[phase][intervalleLatence(traceCourante.phases[phase])];
+        __atomic_store_n(intervalle, *intervalle + 1, __ATOMIC_RELAXED);
+    }
+
+    traceCourante.duree = (uint64_t) ((double) (derniereMarque - debutCourant) * nanosecondesParCycle);
+    intervalle = &tracesLocales.intervalles[NOMBRE_PHASES][intervalleLatence(traceCourante.duree)];
+    __atomic_store_n(intervalle, *intervalle + 1, __ATOMIC_RELAXED);
+
+    garderSiLente();
+}
+
+/**
+ * @brief Recopie les requetes lentes d'un travailleur, en recommencant si elles changent pendant la copie
+ */
+static void copierLentes(Traces *traces, TraceRequete *copie) {
+    uint64_t avant, apres;
+
+    do {
+        // Sequence impaire : le travailleur est en train d'ecrire
+        while ((avant = __atomic_load_n(&traces->sequence, __ATOMIC_ACQUIRE)) & 1) {
+        }
+        memcpy(copie, traces->lentes, sizeof(traces->lentes));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        apres = __atomic_load_n(&traces->sequence, __ATOMIC_RELAXED);
+    } while (avant != apres);
+}
+
+/**
+ * @brief Borne de l'intervalle sous laquelle tombe une proportion des durees, en pour mille
+ */
+static uint64_t quantile(const uint64_t *intervalles, uint64_t nombre, uint64_t pourMille) {
+    uint64_t seuil = (nombre * pourMille + 999) / 1000, cumul = 0;
+    size_t i;
+
+    for (i = 0; i < NOMBRE_INTERVALLES_LATENCE; i++) {
+        if ((cumul += intervalles[i]) >= seuil) {
+            return finIntervalle(i);
+        }
+    }
+
+    return finIntervalle(NOMBRE_INTERVALLES_LATENCE - 1);
+}
+
+/**
+ * @brief Ajoute du texte formate a la page des traces
+ *
+ * @return bool -> Retourne FALSE si la page est pleine
+ */
+static bool ajouterTexte(char *page, size_t *longueur, const char *format, ...) {
+    va_list arguments;
+    int ecrit;
+
+    va_start(arguments, format);
+    ecrit = vsnprintf(&page[*longueur], TAILLE_MAX_TRACE - *longueur, format, arguments);
+    va_end(arguments);
+
+    if ((ecrit < 0) || ((size_t) ecrit >= TAILLE_MAX_TRACE - *longueur)) {
+        fprintf(stderr, "Erreur : page des traces trop longue\n");
+        return FALSE;
+    }
+
+    *longueur += (size_t) ecrit;
+
+    return TRUE;
+}
+
+/**
+ * @brief Formate les quantiles de chaque phase et les requetes les plus lentes de tous les travailleurs
+ *
+ * @return bool -> Retourne FALSE si la page est pleine
+ */
+static bool formaterTraces(char *page, size_t *longueur, const uint64_t (*intervalles)[NOMBRE_INTERVALLES_LATENCE],
+                           const TraceRequete *lentes, size_t nombreLentes) {
+    uint64_t nombre;
+    size_t phase, i;
+
+    if (!(ajouterTexte(page, longueur, "%-13s %10s %10s %10s %10s\n", "phase (ns)", "requetes", "p50", "p99",
+                       "p99.9"))) {
+        return FALSE;
+    }
+
+    for (phase = 0; phase <= NOMBRE_PHASES; phase++) {
+        nombre = 0;
+        for (i = 0; i < NOMBRE_INTERVALLES_LATENCE; i++) {
+            nombre += intervalles[phase][i];
+        }
+
+        if ((nombre > 0) &&
+            (!(ajouterTexte(page, longueur, "%-13s %10llu %10llu %10llu %10llu\n", nomsPhases[phase],
+                            (unsigned long long) nombre,
+                            (unsigned long long) quantile(intervalles[phase], nombre, 500),
+                            (unsigned long long) quantile(intervalles[phase], nombre, 990),
+                            (unsigned long long) quantile(intervalles[phase], nombre, 999))))) {
+            return FALSE;
+        }
+    }
+
+    if (!(ajouterTexte(page, longueur, "\nrequetes les plus lentes (ns) : total"))) {
+        return FALSE;
+    }
+    for (phase = 0; phase < NOMBRE_PHASES; phase++) {
+        if (!(ajouterTexte(page, longueur, " %s", nomsPhases[phase]))) {
+            return FALSE;
+        }
+    }
+    if (!(ajouterTexte(page, longueur, " cible\n"))) {
+        return FALSE;
+    }
+
+    for (i = 0; i < nombreLentes; i++) {
+        if (!(ajouterTexte(page, longueur, "%llu", (unsigned long long) lentes[i].duree))) {
+            return FALSE;
+        }
+        for (phase = 0; phase < NOMBRE_PHASES; phase++) {
+            if (!(ajouterTexte(page, longueur, " %llu", (unsigned long long) lentes[i].phases[phase]))) {
+                return FALSE;
+            }
+        }
+        if (!(ajouterTexte(page, longueur, " %s\n", lentes[i].cible))) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Ordonne les traces de la plus lente a la moins lente
+ */
+static int comparerTraces(const void *a, const void *b) {
+    const TraceRequete *premiere = a, *seconde = b;
+
+    return (premiere->duree < seconde->duree) - (premiere->duree > seconde->duree);
+}
+
+int envoyerTraces(Connexion *connexion) {
+    uint64_t (*intervalles)[NOMBRE_INTERVALLES_LATENCE] = NULL;
+    TraceRequete *lentes = NULL;
+    Traces *traces = NULL;
+    char *page = NULL;
+    size_t longueur = 0, nombreLentes = 0, phase, i;
+    int nombre = __atomic_load_n(&nombreInscrits, __ATOMIC_RELAXED), travailleur, retour = 0;
+
+    if (nombre > MAX_TRAVAILLEURS_MESURES) {
+        nombre = MAX_TRAVAILLEURS_MESURES;
+    }
+
+    if (((intervalles = calloc(NOMBRE_PHASES + 1, sizeof(*intervalles))) == NULL) ||
+        ((lentes = calloc((size_t) nombre * NOMBRE_TRACES_LENTES + 1, sizeof(TraceRequete))) == NULL) ||
+        ((page = malloc(TAILLE_MAX_TRACE)) == NULL)) {
+        fprintf(stderr, "Erreur d'allocation memoire\n");
+        free(intervalles);
+        free(lentes);
+        return 0;
+    }
+
+    // Les histogrammes s'additionnent, les requetes lentes de tous les travailleurs sont classees ensemble
+    for (travailleur = 0; travailleur < nombre; travailleur++) {
+        if ((traces = __atomic_load_n(&tracesTravailleurs[travailleur], __ATOMIC_ACQUIRE)) == NULL) {
+            continue;
+        }
+
+        for (phase = 0; phase <= NOMBRE_PHASES; phase++) {
+            for (i = 0; i < NOMBRE_INTERVALLES_LATENCE; i++) {
+                intervalles[phase][i] += __atomic_load_n(&traces->intervalles[phase][i], __ATOMIC_RELAXED);
+            }
+        }
+
+        copierLentes(traces, &lentes[nombreLentes]);
+        nombreLentes += NOMBRE_TRACES_LENTES;
+    }
+
+    qsort(lentes, nombreLentes, sizeof(TraceRequete), comparerTraces);
+
+    // Les emplacements jamais remplis sont a la fin
+    while ((nombreLentes > 0) && (lentes[nombreLentes - 1].duree == 0)) {
+        nombreLentes--;
+    }
+    if (nombreLentes > NOMBRE_TRACES_LENTES) {
+        nombreLentes = NOMBRE_TRACES_LENTES;
+    }
+
+    if (formaterTraces(page, &longueur, (const uint64_t (*)[NOMBRE_INTERVALLES_LATENCE]) intervalles, lentes,
+                       nombreLentes)) {
+        retour = (EmissionEntete(connexion, "200 OK", "text/plain", (long long) longueur,
+                                 "Cache-Control: no-store\r\n")) &&
+                 (EmissionBinaire(connexion, page, (ssize_t) longueur) >= 0);
+    }
+
+    free(intervalles);
+    free(lentes);
+    free(page);
+
+    return retour;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file    trace.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration du tracage des phases du traitement \n
+ *          Compile seulement avec -DTRACAGE (make trace) : chaque requete est
+ *          decoupee en phases successives (analyse, verification, cache,
+ *          resolution, preparation, emission) horodatees par le compteur de
+ *          cycles. Chaque travailleur tient un histogramme par phase et ses
+ *          requetes les plus lentes, lisibles sur /__trace. Sans -DTRACAGE,
+ *          les macros ne produisent aucun code.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "serveur.h"
+#include "requete.h"
+
+/**
+ * @brief Phases du traitement d'une requete, dans l'ordre ou elles se succedent
+ */
+typedef enum {
+    PHASE_ANALYSE,          /* reception analysee jusqu'a une requete complete */
+    PHASE_VERIFICATION,     /* methode, version et nom du fichier */
+    PHASE_CACHE,            /* recherche dans le cache de reponses */
+    PHASE_RESOLUTION,       /* resolution du fichier, type MIME et validateurs */
+    PHASE_PREPARATION,      /* lecture, compression et mise en sortie de la reponse */
+    PHASE_EMISSION,         /* appels systeme d'emission qui suivent la requete */
+    NOMBRE_PHASES
+} PhaseTrace;
+
+#ifdef TRACAGE
+
+/* Chemin normalise de la page des traces */
+#define CHEMIN_TRACE "__trace"
+/* Nombre de requetes les plus lentes gardees par chaque travailleur */
+#define NOMBRE_TRACES_LENTES 16
+/* Longueur gardee de la cible d'une requete, zero final compris */
+#define LONGUEUR_MAX_CIBLE_TRACE 96
+/* Taille maximale de la page des traces */
+#define TAILLE_MAX_TRACE 65536
+
+#define TRACE_INITIALISER() initialiserTrace()
+#define TRACE_INSCRIRE() inscrireTraces()
+#define TRACE_DEBUT() debuterTrace()
+#define TRACE_REQUETE(requete) ouvrirTrace(requete)
+#define TRACE_PHASE(phase) marquerPhase(phase)
+#define TRACE_FIN() terminerTrace()
+
+/**
+ * @brief   Etalonne le compteur de cycles sur l'horloge monotone \n
+ *          Note : a appeler avant le demarrage des travailleurs
+ */
+void initialiserTrace(void);
+
+/**
+ * @brief   Inscrit les traces du travailleur courant parmi celles lues par /__trace \n
+ *          Note : a appeler au demarrage de chaque travailleur
+ */
+void inscrireTraces(void);
+
+/**
+ * @brief   Note l'instant ou commence l'analyse d'une requete \n
+ *          Note : termine la trace de la requete precedente si elle est encore ouverte
+ */
+void debuterTrace(void);
+
+/**
+ * @brief Ouvre la trace d'une requete complete, a la fin de son analyse
+ *
+ * @param requete   Requete analysee, pour sa cible
+ */
+void ouvrirTrace(const Requete *requete);
+
+/**
+ * @brief Attribue a une phase le temps ecoule depuis la marque precedente
+ *
+ * @param phase Phase qui vient de se terminer
+ */
+void marquerPhase(PhaseTrace phase);
+
+/**
+ * @brief   Attribue le temps restant a l'emission et comptabilise la trace ouverte \n
+ *          Note : sans effet si aucune trace n'est ouverte
+ */
+void terminerTrace(void);
+
+/**
+ * @brief Emet la page de /__trace : quantiles par phase et requetes les plus lentes
+ *
+ * @param connexion Connexion du client
+ * @return          int -> Retourne 1 si ca s'est bien passe, 0 sinon
+ */
+int envoyerTraces(Connexion *connexion);
+
+#else
+
+#define TRACE_INITIALISER() ((void) 0)
+#define TRACE_INSCRIRE() ((void) 0)
+#define TRACE_DEBUT() ((void) 0)
+#define TRACE_REQUETE(requete) ((void) 0)
+#define TRACE_PHASE(phase) ((void) 0)
+#define TRACE_FIN() ((void) 0)
+
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * @file    validation.c
+ * @author  Coulais Alexandre
+ * @brief   Fichier source des validateurs de reponse et des requetes conditionnelles \n
+ *          Les commentaires de description des fonctions,
+ *          avec leurs parametres et valeurs de retour sont dans
+ *          le fichier d'entete. \n Ici figurent les commentaires
+ *          de description du code des fonctions.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#include "validation.h"
+
+/* Format des dates HTTP (IMF-fixdate), toujours en temps universel */
+#define FORMAT_DATE_HTTP "%a, %d %b %Y %H:%M:%S GMT"
+
+/* Duree commune a tous les travailleurs, fixee au demarrage */
+static long dureeCacheClient = DUREE_CACHE_CLIENT_DEFAUT;
+
+void configurerValidation(long dureeSecondes) {
+    dureeCacheClient = dureeSecondes;
+}
+
+void calculerValidateurs(const struct stat *infos, Encodage encodage, Validateurs *validateurs) {
+    static const char *suffixes[] = {"", "-gz", "-br"};
+    struct tm date;
+
+    // Chaque encodage est une representation differente, avec son propre ETag
+    snprintf(validateurs->etag, sizeof(validateurs->etag), "\"%llx-%llx-%llx.%lx%s\"",
+             (unsigned long long) infos->st_ino, (unsigned long long) infos->st_size,
+             (unsigned long long) infos->st_mtim.tv_sec, (unsigned long) infos->st_mtim.tv_nsec,
+             suffixes[encodage]);
+
+    validateurs->modification = infos->st_mtim.tv_sec;
+    gmtime_r(&validateurs->modification, &date);
+    strftime(validateurs->derniereModification, sizeof(validateurs->derniereModification), FORMAT_DATE_HTTP, &date);
+}
+
+/**
+ * @brief Recherche l'ETag parmi la liste d'If-None-Match (comparaison faible : W/ ignore)
+ */
+static bool correspondEtag(const Tranche *liste, const char *etag) {
+    const char *p = liste->debut;
+    const char *fin = liste->debut + liste->longueur;
+    Tranche element;
+
+    while (p < fin) {
+        while ((p < fin) && ((*p == ' ') || (*p == '\t') || (*p == ','))) {
+            p++;
+        }
+
+        element.debut = p;
+        while ((p < fin) && (*p != ',') && (*p != ' ') && (*p != '\t')) {
+            p++;
+        }
+        element.longueur = (size_t) (p - element.debut);
+
+        if ((element.longueur > 2) && (!(strncmp(element.debut, "W/", 2)))) {
+            element.debut += 2;
+            element.longueur -= 2;
+        }
+
+        if ((trancheEgale(&element, "*")) || (trancheEgale(&element, etag))) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Convertit une date HTTP en temps universel
+ *
+ * @return bool -> Retourne FALSE si la date n'est pas au format attendu
+ */
+static bool lireDateHttp(const Tranche *valeur, time_t *instant) {
+    char date[64];
+    struct tm decomposee;
+    char *fin = NULL;
+
+    if (valeur->longueur >= sizeof(date)) {
+        return FALSE;
+    }
+
+    memcpy(date, valeur->debut, valeur->longueur);
+    date[valeur->longueur] = '\0';
+    memset(&decomposee, 0, sizeof(decomposee));
+
+    if (((fin = strptime(date, FORMAT_DATE_HTTP, &decomposee)) == NULL) || (*fin != '\0')) {
+        return FALSE;
+    }
+
+    *instant = timegm(&decomposee);
+
+    return TRUE;
+}
+
+bool estNonModifie(const Requete *requete, const Validateurs *validateurs) {
+    const Tranche *valeur = NULL;
+    time_t date;
+
+    if ((valeur = chercherEntete(requete, "If-None-Match")) != NULL) {
+        return correspondEtag(valeur, validateurs->etag);
+    }
+
+    // La date n'a qu'une precision d'une seconde : on compare a la seconde de modification
+    if (((valeur = chercherEntete(requete, "If-Modified-Since")) != NULL) && (lireDateHttp(valeur, &date))) {
+        return validateurs->modification <= date;
+    }
+
+    return FALSE;
+}
+
+bool plageApplicable(const Requete *requete, const Validateurs *validateurs) {
+    const Tranche *valeur = NULL;
+    time_t date;
+
+    if ((valeur = chercherEntete(requete, "If-Range")) == NULL) {
+        return TRUE;
+    }
+
+    // Un ETag faible ne garantit pas l'identite des octets : il ne correspond jamais
+    if ((valeur->longueur > 0) && (valeur->debut[0] == '"')) {
+        return trancheEgale(valeur, validateurs->etag);
+    }
+
+    return (lireDateHttp(valeur, &date)) && (validateurs->modification == date);
+}
+
+int formaterValidateurs(char *destination, size_t maxDestination, const Validateurs *validateurs, const char *suite) {
+    int longueur;
+
+    longueur = snprintf(destination, maxDestination,
+                        "ETag: %s\r\nLast-Modified: %s\r\nCache-Control: public, max-age=%ld\r\n"
+                        "Accept-Ranges: bytes\r\n%s",
+                        validateurs->etag, validateurs->derniereModification, dureeCacheClient, suite);
+
+    if ((longueur < 0) || ((size_t) longueur >= maxDestination)) {
+        fprintf(stderr, "Erreur au remplissage des validateurs\n");
+        return -1;
+    }
+
+    return longueur;
+}
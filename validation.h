@@ -0,0 +1,87 @@
+/**
+ * @file    validation.h
+ * @author  Coulais Alexandre
+ * @brief   Fichier de declaration des validateurs de reponse et des
+ *          requetes conditionnelles \n
+ *          L'ETag est tire de l'inode, de la taille et de la date de
+ *          modification du fichier (et de l'encodage de la reponse), sans
+ *          lire son contenu. If-None-Match et If-Modified-Since permettent
+ *          alors de repondre 304 sans ouvrir le fichier.
+ * @version 1.2
+ * @date    2020-12-13
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#ifndef __VALIDATION_H__
+#define __VALIDATION_H__
+
+#include "compression.h"
+#include "requete.h"
+#include "serveur.h"
+
+#include <time.h>
+
+/* Duree de conservation par defaut annoncee aux clients (Cache-Control), en secondes */
+#define DUREE_CACHE_CLIENT_DEFAUT 3600
+/* Taille maximale des lignes d'entete de validation */
+#define TAILLE_MAX_VALIDATEURS 256
+
+/**
+ * @brief Validateurs d'une representation d'un fichier
+ */
+typedef struct {
+    char etag[64];                  /* entre guillemets, pret a etre emis */
+    char derniereModification[40];  /* date HTTP de la derniere modification */
+    time_t modification;
+} Validateurs;
+
+/**
+ * @brief   Fixe la duree de conservation annoncee dans Cache-Control \n
+ *          Note : a appeler avant le demarrage des travailleurs
+ *
+ * @param dureeSecondes Valeur de max-age, 0 pour imposer une revalidation a chaque usage
+ */
+void configurerValidation(long dureeSecondes);
+
+/**
+ * @brief Calcule les validateurs d'un fichier pour un encodage de reponse
+ *
+ * @param infos         Etat du fichier lu (stat)
+ * @param encodage      Encodage de la representation, qui la distingue dans l'ETag
+ * @param validateurs   Destination des validateurs
+ */
+void calculerValidateurs(const struct stat *infos, Encodage encodage, Validateurs *validateurs);
+
+/**
+ * @brief   Indique si la copie du client est encore valide \n
+ *          Note : If-None-Match l'emporte sur If-Modified-Since quand les deux sont presents
+ *
+ * @param requete       Requete analysee
+ * @param validateurs   Validateurs de la representation courante
+ * @return              bool -> Retourne TRUE si une reponse 304 suffit, FALSE sinon
+ */
+bool estNonModifie(const Requete *requete, const Validateurs *validateurs);
+
+/**
+ * @brief   Indique si l'en-tete Range doit etre honore au vu d'If-Range \n
+ *          Note : l'ETag est compare fortement, la date doit etre celle de la derniere modification
+ *
+ * @param requete       Requete analysee
+ * @param validateurs   Validateurs de la representation courante
+ * @return              bool -> Retourne TRUE si If-Range est absent ou correspond, FALSE sinon
+ */
+bool plageApplicable(const Requete *requete, const Validateurs *validateurs);
+
+/**
+ * @brief Formate les lignes ETag, Last-Modified, Cache-Control et Accept-Ranges, suivies d'autres lignes
+ *
+ * @param destination       Tampon recevant les lignes
+ * @param maxDestination    Taille du tampon
+ * @param validateurs       Validateurs de la representation
+ * @param suite             Lignes a ajouter a la suite (encodage par exemple), "" si aucune
+ * @return                  int -> Retourne la longueur ecrite, -1 si elle ne rentre pas
+ */
+int formaterValidateurs(char *destination, size_t maxDestination, const Validateurs *validateurs, const char *suite);
+
+#endif